@@ -0,0 +1,26 @@
+#!/usr/bin/env python3
+"""
+Generate the gamma lookup table in src/app/led_anim.c
+
+Maps an 8-bit perceptual level to the 8-bit PWM duty a WS2812 needs to
+look that bright: out = 255 * (in / 255) ^ GAMMA, rounded. Paste the
+output over the table in led_anim.c when GAMMA changes.
+"""
+
+GAMMA = 2.2
+PER_LINE = 16
+
+
+def main():
+    values = [round(255 * (i / 255) ** GAMMA) for i in range(256)]
+    print(f"// perceptual level to PWM duty, gamma {GAMMA}")
+    print("// generated by scripts/gen_gamma_table.py")
+    print("static const uint8_t gamma_table[256] = {")
+    for i in range(0, len(values), PER_LINE):
+        row = ", ".join(f"{v:3d}" for v in values[i:i + PER_LINE])
+        print(f"    {row},")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,33 @@
+#!/usr/bin/env python3
+"""
+Generate the saturation vapour pressure table in src/app/psychro.c
+
+Magnus formula over water (Sonntag 1990 constants), one entry per degree
+from SVP_MIN_C to SVP_MAX_C, in millipascals. Paste the output over the
+table in psychro.c when the range or constants change.
+"""
+import math
+
+SVP_MIN_C = -60
+SVP_MAX_C = 85
+PER_LINE = 6
+
+
+def svp_pa(celsius):
+    """Saturation vapour pressure in pascals"""
+    return 611.2 * math.exp(17.62 * celsius / (243.12 + celsius))
+
+
+def main():
+    values = [round(svp_pa(t) * 1000) for t in range(SVP_MIN_C, SVP_MAX_C + 1)]
+    print(f"// saturation vapour pressure in mPa, {SVP_MIN_C} to {SVP_MAX_C} C in 1 C steps")
+    print("// generated by scripts/gen_svp_table.py")
+    print("static const uint32_t svp_table[SVP_ENTRIES] = {")
+    for i in range(0, len(values), PER_LINE):
+        row = ", ".join(f"{v}u" for v in values[i:i + PER_LINE])
+        print(f"    {row},")
+    print("};")
+
+
+if __name__ == "__main__":
+    main()
@@ -11,6 +11,7 @@ import glob
 import argparse
 import random
 from quotes import QUIT_QUOTES
+from telemetry import FrameDecoder
 from serial.tools import list_ports
 
 def print_quit_quote():
@@ -110,6 +111,26 @@ class PicoShell(cmd.Cmd):
         self.ser.close()
         return True
 
+    def do_monitor(self, arg):
+        """Switch the Pico to binary telemetry and print decoded frames until Ctrl-C"""
+        self.ser.write(b"mode binary\n")
+        decoder = FrameDecoder()
+
+        print("  Monitoring binary telemetry (Ctrl-C to stop)")
+        try:
+            while True:
+                data = self.ser.read(self.ser.in_waiting or 1)
+                for message in decoder.feed(data):
+                    print(f"  {message}")
+        except KeyboardInterrupt:
+            pass
+        finally:
+            self.ser.write(b"mode text\n")
+            time.sleep(0.1)
+            self.ser.reset_input_buffer()
+
+        print(f"\n  Stopped ({decoder.rejected} non-frame chunks skipped)")
+
     def do_help(self, arg):
         """Show help from Pico (overrides built-in help)"""
         # Forward 'help' to Pico instead of showing local help
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Record the Pico's sample stream to a CSV file
+
+Sends 'stream <hz>', writes every streamed line with the host receive time,
+and sends 'stream 0' on exit (Ctrl-C). --fields adds derived metrics
+(dew, heat, abs) as extra columns. Lines that are not samples, such as
+command replies, are skipped.
+"""
+import argparse
+import csv
+import re
+import sys
+import time
+import serial
+
+# timestamp_ms,temp_c,humidity[,derived...] as printed by the firmware
+SAMPLE_LINE = re.compile(r"^\d+(,-?\d+\.\d+){2,5}$")
+
+# derived metric columns, in the order the firmware prints them
+DERIVED_COLUMNS = {"dew": "dew_c", "heat": "heat_c", "abs": "abs_g_m3"}
+
+
+def record(ser, writer, outfile):
+    """Copy sample lines from the serial port to the CSV writer until Ctrl-C"""
+    count = 0
+
+    while True:
+        line = ser.readline().decode("utf-8", errors="ignore").strip()
+        if not SAMPLE_LINE.match(line):
+            continue
+
+        writer.writerow([f"{time.time():.3f}", *line.split(",")])
+        outfile.flush()
+        count += 1
+        print(f"\r  {count} samples recorded", end="")
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Record the Pico sample stream to CSV")
+    parser.add_argument("port", help="Serial port (e.g. /dev/ttyACM0, COM3)")
+    parser.add_argument("output", help="CSV file to write")
+    parser.add_argument("-r", "--rate", type=int, default=1, help="Samples per second, 1-10 (default: 1)")
+    parser.add_argument("-b", "--baudrate", type=int, default=115200, help="Baud rate (default: 115200)")
+    parser.add_argument("-a", "--append", action="store_true", help="Append instead of overwriting")
+    parser.add_argument("-f", "--fields", default="",
+                        help="Comma-separated derived metrics to add: dew,heat,abs")
+    args = parser.parse_args()
+
+    fields = [f for f in DERIVED_COLUMNS if f in args.fields.split(",")]
+
+    try:
+        ser = serial.Serial(args.port, args.baudrate, timeout=1)
+    except serial.SerialException as e:
+        print(f"Failed to connect to {args.port}: {e}")
+        sys.exit(1)
+
+    with open(args.output, "a" if args.append else "w", newline="") as outfile:
+        writer = csv.writer(outfile)
+        if not args.append or outfile.tell() == 0:
+            writer.writerow(["host_time", "device_ms", "temp_c", "humidity",
+                             *(DERIVED_COLUMNS[f] for f in fields)])
+
+        ser.reset_input_buffer()
+        for name in DERIVED_COLUMNS:
+            ser.write(f"field {name} {'on' if name in fields else 'off'}\n".encode())
+        ser.write(f"stream {args.rate}\n".encode())
+        print(f"Recording {args.port} at {args.rate} Hz to {args.output} (Ctrl-C to stop)")
+
+        try:
+            record(ser, writer, outfile)
+        except KeyboardInterrupt:
+            pass
+        finally:
+            ser.write(b"stream 0\n")
+            ser.close()
+
+    print("\nStopped")
+
+
+if __name__ == "__main__":
+    main()
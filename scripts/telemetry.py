@@ -0,0 +1,131 @@
+"""
+Decoder for the binary telemetry frames sent by the Pico in 'mode binary'
+
+Frame (before encoding): type u8 | seq u8 | payload | crc16 u16 LE
+CRC-16/CCITT-FALSE over type, seq and payload; COBS encoded; 0x00 delimited.
+Must match src/interfaces/telemetry.h
+"""
+import struct
+
+MSG_SAMPLE = 0x01
+MSG_STATS = 0x02
+MSG_CONFIG = 0x03
+MSG_ACK = 0x04
+MSG_SAMPLE_DERIVED = 0x05
+MSG_ALARM = 0x06
+
+# payload layouts (little-endian, packed)
+SAMPLE_FORMAT = "<Iii"
+STATS_FORMAT = "<9I"
+CONFIG_FORMAT = "<BBB"
+ACK_FORMAT = "<B15s"
+DERIVED_FORMAT = "<IiiBiii"
+ALARM_FORMAT = "<IBBBBi"
+
+ALARM_CHANNELS = ("temp", "humid", "dew", "heat")
+ALARM_KINDS = ("high", "low", "rise", "fall")
+
+# derived metric bits in MSG_SAMPLE_DERIVED, as src/app/psychro.h
+DERIVED_FIELDS = ((1, "dew_c"), (2, "heat_c"), (4, "abs_g_m3"))
+
+STATS_FIELDS = ("samples", "retries", "failures", "i2c_errors",
+                "crc_errors", "busy_errors", "cal_errors", "queue_overflows",
+                "tx_overruns")
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF)"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(data):
+    """Decode one COBS block (without delimiters), or None if malformed"""
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            return None
+        out += data[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_message(frame):
+    """Turn a decoded frame into a dict, or None if the CRC or layout is wrong"""
+    if len(frame) < 4:
+        return None
+    body, (crc,) = frame[:-2], struct.unpack("<H", frame[-2:])
+    if crc16(body) != crc:
+        return None
+
+    msg_type, seq, payload = body[0], body[1], body[2:]
+    try:
+        if msg_type == MSG_SAMPLE:
+            ts, temp, humidity = struct.unpack(SAMPLE_FORMAT, payload)
+            return {"type": "sample", "seq": seq, "timestamp_ms": ts,
+                    "temp_c": temp / 100, "humidity": humidity / 100}
+        if msg_type == MSG_SAMPLE_DERIVED:
+            ts, temp, humidity, fields, *derived = struct.unpack(DERIVED_FORMAT, payload)
+            message = {"type": "sample", "seq": seq, "timestamp_ms": ts,
+                       "temp_c": temp / 100, "humidity": humidity / 100}
+            for (bit, name), value in zip(DERIVED_FIELDS, derived):
+                if fields & bit:
+                    message[name] = value / 100
+            return message
+        if msg_type == MSG_ALARM:
+            ts, rule, channel, kind, fired, value = struct.unpack(ALARM_FORMAT, payload)
+            return {"type": "alarm", "seq": seq, "timestamp_ms": ts, "rule": rule,
+                    "channel": ALARM_CHANNELS[channel] if channel < len(ALARM_CHANNELS) else channel,
+                    "kind": ALARM_KINDS[kind] if kind < len(ALARM_KINDS) else kind,
+                    "fired": bool(fired), "value": value / 100}
+        if msg_type == MSG_STATS:
+            values = struct.unpack(STATS_FORMAT, payload)
+            return {"type": "stats", "seq": seq, **dict(zip(STATS_FIELDS, values))}
+        if msg_type == MSG_CONFIG:
+            unit, pattern, mock = struct.unpack(CONFIG_FORMAT, payload)
+            return {"type": "config", "seq": seq, "unit": "CF"[unit & 1],
+                    "pattern": pattern, "mock": bool(mock)}
+        if msg_type == MSG_ACK:
+            ok, command = struct.unpack(ACK_FORMAT, payload)
+            return {"type": "ack", "seq": seq, "ok": bool(ok),
+                    "command": command.rstrip(b"\0").decode(errors="replace")}
+    except struct.error:
+        return None
+    return {"type": "unknown", "seq": seq, "msg_type": msg_type, "payload": payload}
+
+
+class FrameDecoder:
+    """Incremental decoder: feed raw serial bytes, get decoded messages back
+
+    Anything between delimiters that is not a valid frame (such as text
+    printed by a command) is counted in `rejected` and skipped.
+    """
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.rejected = 0
+
+    def feed(self, data):
+        messages = []
+        for byte in data:
+            if byte != 0:
+                self.buffer.append(byte)
+                continue
+            if self.buffer:
+                frame = cobs_decode(bytes(self.buffer))
+                message = parse_message(frame) if frame is not None else None
+                if message is None:
+                    self.rejected += 1
+                else:
+                    messages.append(message)
+                self.buffer.clear()
+        return messages
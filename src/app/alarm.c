@@ -0,0 +1,369 @@
+/**
+ * @file alarm.c
+ * @brief Threshold alarm rules evaluated on every sample
+ *
+ * Runs on core0 only: rules are evaluated from the UI task and edited by
+ * commands, so no locking is needed.
+ */
+
+#include <string.h>
+#include "alarm.h"
+#include "psychro.h"
+
+#define EVENT_MASK (ALARM_EVENT_QUEUE_SIZE - 1)
+
+// One enabled rule, normalized so every test is "x >= set" to fire and
+// "x < clear" to clear, with x the value (or rate) times sign
+typedef struct
+{
+    uint8_t rule;
+    uint8_t channel;
+    bool rate;
+    int8_t sign;
+    int32_t set_level;
+    int32_t clear_level;
+    uint32_t hold_ms;
+} compiled_rule_t;
+
+typedef struct
+{
+    bool active;
+    bool pending;           // condition for the next transition holds
+    uint32_t pending_since;
+    uint32_t fire_count;
+    int32_t last_value;
+} rule_state_t;
+
+static const char* const channel_names[ALARM_CHANNELS] = {"temp", "humid", "dew", "heat"};
+static const char* const kind_names[] = {"high", "low", "rise", "fall"};
+
+static alarm_rule_t rules[ALARM_MAX_RULES];
+static rule_state_t states[ALARM_MAX_RULES];
+static compiled_rule_t table[ALARM_MAX_RULES];
+static uint8_t table_len = 0;
+static uint8_t channels_used = 0;   // channels read by any compiled rule
+static uint8_t rate_channels = 0;   // channels with a rate rule
+static uint32_t active_mask = 0;
+static uint32_t last_sample_ms = 0;
+
+// channel values at the start of each rate slot, oldest at slot_head
+static int32_t slot_value[ALARM_RATE_SLOTS][ALARM_CHANNELS];
+static uint32_t slot_time[ALARM_RATE_SLOTS];
+static uint8_t slot_head = 0;
+static uint8_t slot_count = 0;
+
+static alarm_event_t events[ALARM_EVENT_QUEUE_SIZE];
+static uint32_t event_head = 0;   // events ever queued
+
+/**
+ * @brief rebuild the dense table from the enabled rules
+ */
+static void compile_rules(void)
+{
+    uint8_t old_rate_channels = rate_channels;
+
+    table_len = 0;
+    channels_used = 0;
+    rate_channels = 0;
+
+    for (uint8_t i = 0; i < ALARM_MAX_RULES; i++)
+    {
+        const alarm_rule_t* r = &rules[i];
+        if (!r->enabled)
+        {
+            continue;
+        }
+
+        compiled_rule_t* c = &table[table_len++];
+        c->rule = i;
+        c->channel = r->channel;
+        c->rate = (r->kind == ALARM_RISE || r->kind == ALARM_FALL);
+        c->sign = (r->kind == ALARM_HIGH || r->kind == ALARM_RISE) ? 1 : -1;
+        c->set_level = c->sign * r->threshold;
+        c->clear_level = c->set_level - r->hysteresis;
+        c->hold_ms = r->hold_ms;
+
+        channels_used |= (uint8_t)(1u << r->channel);
+        if (c->rate)
+        {
+            rate_channels |= (uint8_t)(1u << r->channel);
+        }
+    }
+
+    // slots hold no history for a channel that was not tracked
+    if (rate_channels != old_rate_channels)
+    {
+        slot_count = 0;
+    }
+}
+
+/**
+ * @brief queue a transition, overwriting the oldest event when full
+ */
+static void push_event(uint8_t rule, bool fired, int32_t value, uint32_t timestamp_ms)
+{
+    alarm_event_t* ev = &events[event_head & EVENT_MASK];
+
+    ev->timestamp_ms = timestamp_ms;
+    ev->rule = rule;
+    ev->channel = rules[rule].channel;
+    ev->kind = rules[rule].kind;
+    ev->fired = fired;
+    ev->value = value;
+    event_head++;
+}
+
+/**
+ * @brief drop a rule's state, queuing a clear if it was active
+ */
+static void reset_state(uint8_t index)
+{
+    if (states[index].active)
+    {
+        push_event(index, false, states[index].last_value, last_sample_ms);
+        active_mask &= ~(1u << index);
+    }
+    memset(&states[index], 0, sizeof(states[index]));
+}
+
+/**
+ * @brief install the default rule: temperature at or above 96 F
+ */
+void alarm_init(void)
+{
+    alarm_rule_t rule = {
+        .enabled = true,
+        .channel = ALARM_CH_TEMP,
+        .kind = ALARM_HIGH,
+        .threshold = 3556,      // 96 F
+        .hysteresis = 50,
+        .hold_ms = 0,
+    };
+
+    memset(rules, 0, sizeof(rules));
+    memset(states, 0, sizeof(states));
+    active_mask = 0;
+    alarm_set_rule(0, &rule);
+}
+
+/**
+ * @brief per-minute rates of the rate channels over the last minute
+ *
+ * @details Records the values at the start of each 10 s slot; the rate is
+ * measured against the oldest slot, so it needs one full slot of history
+ *
+ * @return false while there is not enough history
+ */
+static bool update_rates(const int32_t* values, uint32_t now, int32_t* rates)
+{
+    if (slot_count == 0 ||
+        now - slot_time[(slot_head + slot_count - 1) % ALARM_RATE_SLOTS] >= ALARM_RATE_SLOT_MS)
+    {
+        uint8_t slot;
+        if (slot_count < ALARM_RATE_SLOTS)
+        {
+            slot = (uint8_t)((slot_head + slot_count) % ALARM_RATE_SLOTS);
+            slot_count++;
+        }
+        else
+        {
+            slot = slot_head;
+            slot_head = (uint8_t)((slot_head + 1) % ALARM_RATE_SLOTS);
+        }
+        memcpy(slot_value[slot], values, sizeof(slot_value[slot]));
+        slot_time[slot] = now;
+    }
+
+    uint32_t dt = now - slot_time[slot_head];
+    if (dt < ALARM_RATE_SLOT_MS)
+    {
+        return false;
+    }
+
+    for (uint8_t ch = 0; ch < ALARM_CHANNELS; ch++)
+    {
+        if (rate_channels & (1u << ch))
+        {
+            rates[ch] = (int32_t)((int64_t)(values[ch] - slot_value[slot_head][ch]) * 60000 / dt);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief run every enabled rule against a sample
+ *
+ * @param sample validated sample in centi-units
+ */
+void alarm_evaluate(const sensor_sample_t* sample)
+{
+    int32_t values[ALARM_CHANNELS] = {sample->temp, sample->humidity, 0, 0};
+    int32_t rates[ALARM_CHANNELS] = {0};
+    uint32_t now = sample->timestamp_ms;
+
+    last_sample_ms = now;
+
+    // derived channels cost a table lookup, so only when a rule needs them
+    if (channels_used & (1u << ALARM_CH_DEW_POINT))
+    {
+        values[ALARM_CH_DEW_POINT] = psychro_dew_point(sample->temp, sample->humidity);
+    }
+    if (channels_used & (1u << ALARM_CH_HEAT_INDEX))
+    {
+        values[ALARM_CH_HEAT_INDEX] = psychro_heat_index(sample->temp, sample->humidity);
+    }
+    bool have_rates = (rate_channels != 0) && update_rates(values, now, rates);
+
+    for (uint8_t i = 0; i < table_len; i++)
+    {
+        const compiled_rule_t* c = &table[i];
+        rule_state_t* s = &states[c->rule];
+
+        if (c->rate && !have_rates)
+        {
+            continue;
+        }
+
+        int32_t value = c->rate ? rates[c->channel] : values[c->channel];
+        int32_t x = c->sign * value;
+        bool transition = s->active ? (x < c->clear_level) : (x >= c->set_level);
+        s->last_value = value;
+
+        if (!transition)
+        {
+            s->pending = false;
+            continue;
+        }
+        if (!s->pending)
+        {
+            s->pending = true;
+            s->pending_since = now;
+        }
+        if (now - s->pending_since < c->hold_ms)
+        {
+            continue;
+        }
+
+        s->pending = false;
+        s->active = !s->active;
+        if (s->active)
+        {
+            s->fire_count++;
+            active_mask |= 1u << c->rule;
+        }
+        else
+        {
+            active_mask &= ~(1u << c->rule);
+        }
+        push_event(c->rule, s->active, value, now);
+    }
+}
+
+/**
+ * @brief add or replace a rule
+ *
+ * @details Replacing a rule restarts its state and fire count; an
+ * active alarm is cleared first
+ *
+ * @return false if the index, channel or kind is out of range
+ */
+bool alarm_set_rule(uint8_t index, const alarm_rule_t* rule)
+{
+    if (index >= ALARM_MAX_RULES || rule->channel >= ALARM_CHANNELS || rule->kind > ALARM_FALL)
+    {
+        return false;
+    }
+
+    reset_state(index);
+    rules[index] = *rule;
+    compile_rules();
+    return true;
+}
+
+/**
+ * @brief copy a rule out
+ *
+ * @return false if the index is out of range or the slot is empty
+ */
+bool alarm_get_rule(uint8_t index, alarm_rule_t* out)
+{
+    if (index >= ALARM_MAX_RULES || !rules[index].enabled)
+    {
+        return false;
+    }
+    *out = rules[index];
+    return true;
+}
+
+/**
+ * @brief remove a rule, clearing it if active
+ */
+void alarm_delete_rule(uint8_t index)
+{
+    if (index >= ALARM_MAX_RULES)
+    {
+        return;
+    }
+    reset_state(index);
+    rules[index].enabled = false;
+    compile_rules();
+}
+
+/**
+ * @brief bit n is set while rule n is firing
+ */
+uint32_t alarm_active_mask(void)
+{
+    return active_mask;
+}
+
+/**
+ * @brief times a rule has fired since boot
+ */
+uint32_t alarm_fire_count(uint8_t index)
+{
+    return (index < ALARM_MAX_RULES) ? states[index].fire_count : 0;
+}
+
+/**
+ * @brief cursor value that reads only events queued from now on
+ */
+uint32_t alarm_event_head(void)
+{
+    return event_head;
+}
+
+/**
+ * @brief read the next event for one consumer
+ *
+ * @param cursor the consumer's position, advanced past the event read
+ * @param out location to store the event
+ *
+ * @return false if the consumer has read every event
+ */
+bool alarm_event_read(uint32_t* cursor, alarm_event_t* out)
+{
+    if (event_head - *cursor > ALARM_EVENT_QUEUE_SIZE)
+    {
+        // lapped: older events were overwritten
+        *cursor = event_head - ALARM_EVENT_QUEUE_SIZE;
+    }
+    if (*cursor == event_head)
+    {
+        return false;
+    }
+
+    *out = events[*cursor & EVENT_MASK];
+    (*cursor)++;
+    return true;
+}
+
+const char* alarm_channel_name(uint8_t channel)
+{
+    return (channel < ALARM_CHANNELS) ? channel_names[channel] : "?";
+}
+
+const char* alarm_kind_name(uint8_t kind)
+{
+    return (kind <= ALARM_FALL) ? kind_names[kind] : "?";
+}
@@ -0,0 +1,77 @@
+/**
+ * @file alarm.h
+ * @brief Threshold alarm rules evaluated on every sample
+ *
+ * A rule watches one channel for a level (high/low) or a rate of change
+ * (rise/fall, per minute). A rule fires once its condition has held for
+ * hold_ms, and clears once the value has been back inside the hysteresis
+ * band for hold_ms. Rules are edited at runtime and compiled into a dense
+ * table, so each sample costs at most ALARM_MAX_RULES comparisons.
+ *
+ * Fired and cleared transitions go into a bounded event queue. Every
+ * consumer (LCD, LEDs, serial) keeps its own read cursor, so one slow
+ * consumer never hides events from the others; a consumer that falls more
+ * than ALARM_EVENT_QUEUE_SIZE events behind skips to the oldest one held.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+#define ALARM_MAX_RULES 8
+#define ALARM_EVENT_QUEUE_SIZE 16   // must be a power of two
+
+// Rate of change is measured over the last minute in 10 s slots
+#define ALARM_RATE_SLOTS 6
+#define ALARM_RATE_SLOT_MS 10000
+
+typedef enum
+{
+    ALARM_CH_TEMP,          // centi-degrees celsius
+    ALARM_CH_HUMIDITY,      // centi-percent
+    ALARM_CH_DEW_POINT,     // centi-degrees celsius
+    ALARM_CH_HEAT_INDEX,    // centi-degrees celsius
+    ALARM_CHANNELS
+} alarm_channel_t;
+
+typedef enum
+{
+    ALARM_HIGH,     // value >= threshold
+    ALARM_LOW,      // value <= threshold
+    ALARM_RISE,     // rises by >= threshold per minute
+    ALARM_FALL      // falls by >= threshold per minute
+} alarm_kind_t;
+
+typedef struct
+{
+    bool enabled;
+    uint8_t channel;        // alarm_channel_t
+    uint8_t kind;           // alarm_kind_t
+    int32_t threshold;      // centi-units, or centi-units per minute
+    int32_t hysteresis;     // clears this far back inside the threshold
+    uint32_t hold_ms;       // condition must hold this long to fire or clear
+} alarm_rule_t;
+
+typedef struct
+{
+    uint32_t timestamp_ms;
+    uint8_t rule;
+    uint8_t channel;
+    uint8_t kind;
+    bool fired;             // false when the alarm cleared
+    int32_t value;          // value (or rate) that caused the transition
+} alarm_event_t;
+
+void alarm_init(void);
+void alarm_evaluate(const sensor_sample_t* sample);
+bool alarm_set_rule(uint8_t index, const alarm_rule_t* rule);
+bool alarm_get_rule(uint8_t index, alarm_rule_t* out);
+void alarm_delete_rule(uint8_t index);
+uint32_t alarm_active_mask(void);
+uint32_t alarm_fire_count(uint8_t index);
+uint32_t alarm_event_head(void);
+bool alarm_event_read(uint32_t* cursor, alarm_event_t* out);
+const char* alarm_channel_name(uint8_t channel);
+const char* alarm_kind_name(uint8_t kind);
@@ -0,0 +1,11 @@
+/**
+ * @file crc16.h
+ * @brief CRC-16/CCITT-FALSE shared by telemetry frames and the flash store
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+uint16_t crc16_ccitt(const uint8_t* data, size_t len);
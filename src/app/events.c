@@ -0,0 +1,130 @@
+/**
+ * @file events.c
+ * @brief Tickless event loop: IRQs post events, the main loop sleeps until one is pending
+ */
+
+#include <stddef.h>
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include "events.h"
+
+static event_stats_t stats[EVENT_COUNT];
+
+// Pending flags are set by posters (IRQ or the other core) and cleared
+// by event_take() before the consumer runs, so a post that races with
+// dispatch is never lost: at worst the consumer runs once more.
+static volatile bool pending[EVENT_COUNT];
+static volatile uint32_t post_time_us[EVENT_COUNT];
+
+static const char* const names[EVENT_COUNT] = {
+    [EVENT_USB_RX] = "usb_rx",
+    [EVENT_SENSOR_STEP] = "sensor",
+    [EVENT_SAMPLE_READY] = "sample",
+    [EVENT_TX_READY] = "usb_tx",
+    [EVENT_LOG] = "log",
+    [EVENT_HISTORY] = "history",
+    [EVENT_TIMER] = "timer",
+};
+
+/**
+ * @brief mark an event pending and wake the core
+ *
+ * Safe to call from IRQ context and from either core
+ *
+ * @param type the event to post
+ */
+void event_post(event_type_t type)
+{
+    if (type >= EVENT_COUNT)
+    {
+        return;
+    }
+
+    // latency is measured from the first post of a coalesced batch
+    if (!pending[type])
+    {
+        post_time_us[type] = time_us_32();
+    }
+    pending[type] = true;
+
+    __sev();
+}
+
+/**
+ * @brief check whether any event is pending
+ */
+static bool any_pending(void)
+{
+    for (uint8_t i = 0; i < EVENT_COUNT; i++)
+    {
+        if (pending[i])
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief sleep until at least one event is pending
+ *
+ * An IRQ that posts between the check and __wfe() sets the event
+ * register on exception return, so __wfe() falls straight through
+ */
+void event_wait(void)
+{
+    while (!any_pending())
+    {
+        __wfe();
+    }
+}
+
+/**
+ * @brief consume a pending event and record its dispatch latency
+ *
+ * @param type the event to take
+ * @param posted_at_us location to store when the event was first posted
+ * (time_us_32() clock), may be NULL
+ *
+ * @return true if the event was pending
+ */
+bool event_take(event_type_t type, uint32_t* posted_at_us)
+{
+    if (type >= EVENT_COUNT || !pending[type])
+    {
+        return false;
+    }
+
+    uint32_t posted_at = post_time_us[type];
+    uint32_t latency = time_us_32() - posted_at;
+    pending[type] = false;
+
+    stats[type].dispatched++;
+    stats[type].total_latency_us += latency;
+    if (latency > stats[type].max_latency_us)
+    {
+        stats[type].max_latency_us = latency;
+    }
+
+    if (posted_at_us != NULL)
+    {
+        *posted_at_us = posted_at;
+    }
+    return true;
+}
+
+/**
+ * @brief get the dispatch statistics of an event
+ */
+const event_stats_t* event_get_stats(event_type_t type)
+{
+    return (type < EVENT_COUNT) ? &stats[type] : NULL;
+}
+
+/**
+ * @brief get the display name of an event
+ */
+const char* event_name(event_type_t type)
+{
+    return (type < EVENT_COUNT) ? names[type] : "?";
+}
@@ -0,0 +1,41 @@
+/**
+ * @file events.h
+ * @brief Tickless event loop: IRQs post events, the main loop sleeps until one is pending
+ *
+ * Events coalesce: posting an event that is already pending only wakes
+ * the core again. Consumers therefore drain whatever state they own
+ * (input buffer, sample queue) rather than assuming one post per item.
+ * The scheduler takes events and runs the task bound to each one.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Event types, dispatched in this order (lowest value first)
+typedef enum
+{
+    EVENT_USB_RX,        // characters available on USB stdio
+    EVENT_SENSOR_STEP,   // sensor state machine has work to do
+    EVENT_SAMPLE_READY,  // sample queue is non-empty
+    EVENT_TX_READY,      // USB TX ring has output to drain
+    EVENT_LOG,           // samples are waiting to be logged to history and flash
+    EVENT_HISTORY,       // history dump has entries left to send
+    EVENT_TIMER,         // scheduler alarm for periodic tasks
+    EVENT_COUNT
+} event_type_t;
+
+// Per-event dispatch statistics
+typedef struct
+{
+    uint32_t dispatched;        // times the event was taken
+    uint32_t max_latency_us;    // worst post-to-dispatch delay
+    uint64_t total_latency_us;  // sum of post-to-dispatch delays
+} event_stats_t;
+
+void event_post(event_type_t type);
+void event_wait(void);
+bool event_take(event_type_t type, uint32_t* posted_at_us);
+const event_stats_t* event_get_stats(event_type_t type);
+const char* event_name(event_type_t type);
@@ -0,0 +1,79 @@
+/**
+ * @file fixed_point.c
+ * @brief Integer helpers for the centi-unit sensor pipeline
+ */
+
+#include <stdio.h>
+#include "fixed_point.h"
+
+/**
+ * @brief Divide rounding half away from zero
+ */
+static int32_t div_round(int32_t num, int32_t den)
+{
+    return (num >= 0) ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+/**
+ * @brief Convert centi-degrees celsius to centi-degrees fahrenheit
+ *
+ * @param celsius_centi temperature in centi-degrees celsius
+ * @return temperature in centi-degrees fahrenheit
+ */
+int32_t celsius_to_fahrenheit_centi(int32_t celsius_centi)
+{
+    return div_round(celsius_centi * 9, 5) + 32 * CENTI_PER_UNIT;
+}
+
+/**
+ * @brief Convert centi-degrees fahrenheit to centi-degrees celsius
+ *
+ * @param fahrenheit_centi temperature in centi-degrees fahrenheit
+ * @return temperature in centi-degrees celsius
+ */
+int32_t fahrenheit_to_celsius_centi(int32_t fahrenheit_centi)
+{
+    return div_round((fahrenheit_centi - 32 * CENTI_PER_UNIT) * 5, 9);
+}
+
+/**
+ * @brief Format a centi-unit value with one decimal place (2256 -> "22.6")
+ *
+ * Rounds half away from zero like printf("%.1f") without pulling in
+ * float printf support
+ *
+ * @param buf destination buffer
+ * @param size size of the destination buffer
+ * @param centi value in centi-units
+ *
+ * @return number of characters that would have been written (snprintf)
+ */
+int fixed_format_tenths(char* buf, size_t size, int32_t centi)
+{
+    int32_t tenths = div_round(centi, 10);
+    uint32_t magnitude = (tenths < 0) ? (uint32_t)-tenths : (uint32_t)tenths;
+
+    return snprintf(buf, size, "%s%lu.%lu",
+                    (tenths < 0) ? "-" : "",
+                    (unsigned long)(magnitude / 10),
+                    (unsigned long)(magnitude % 10));
+}
+
+/**
+ * @brief Format a centi-unit value with both decimal places (-512 -> "-5.12")
+ *
+ * @param buf destination buffer
+ * @param size size of the destination buffer
+ * @param centi value in centi-units
+ *
+ * @return number of characters that would have been written (snprintf)
+ */
+int fixed_format_hundredths(char* buf, size_t size, int32_t centi)
+{
+    uint32_t magnitude = (centi < 0) ? (uint32_t)-centi : (uint32_t)centi;
+
+    return snprintf(buf, size, "%s%lu.%02lu",
+                    (centi < 0) ? "-" : "",
+                    (unsigned long)(magnitude / CENTI_PER_UNIT),
+                    (unsigned long)(magnitude % CENTI_PER_UNIT));
+}
@@ -0,0 +1,19 @@
+/**
+ * @file fixed_point.h
+ * @brief Integer helpers for the centi-unit sensor pipeline
+ *
+ * Temperatures are carried as centi-degrees and humidity as centi-percent
+ * in int32_t (e.g. 2256 == 22.56), so no soft-float is needed on the M0+.
+ */
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CENTI_PER_UNIT 100
+
+int32_t celsius_to_fahrenheit_centi(int32_t celsius_centi);
+int32_t fahrenheit_to_celsius_centi(int32_t fahrenheit_centi);
+int fixed_format_tenths(char* buf, size_t size, int32_t centi);
+int fixed_format_hundredths(char* buf, size_t size, int32_t centi);
@@ -0,0 +1,361 @@
+/**
+ * @file flash_store.c
+ * @brief Append-only, log-structured sample store in flash
+ *
+ * Builds without the Pico SDK so it can run on the host against
+ * flash_backend_file.c
+ */
+
+#include <string.h>
+#include "crc16.h"
+#include "flash_store.h"
+
+#define SECTOR_MAGIC 0x534C4F47u   // "SLOG"
+#define PAGE_MAGIC 0x4B50u         // "PK": payload is a sample_codec block
+
+// Sector header, at the start of page 0
+typedef struct __attribute__((packed))
+{
+    uint32_t magic;
+    uint32_t seq;           // absolute sector sequence number
+    uint32_t erase_count;   // times this sector has been erased
+    uint16_t reserved;
+    uint16_t crc;           // over the preceding bytes
+} sector_header_t;
+
+// One data page
+typedef struct __attribute__((packed))
+{
+    uint16_t magic;
+    uint16_t count;         // samples in the block
+    uint32_t seq;           // absolute page sequence number
+    uint8_t payload[STORE_PAGE_PAYLOAD];
+    uint16_t crc;           // commit marker, over everything before it
+} store_page_t;
+
+_Static_assert(sizeof(store_page_t) == FLASH_STORE_PAGE_SIZE, "store_page_t must fill a page");
+
+static const flash_backend_t* flash = NULL;
+static uint32_t num_sectors = 0;
+static uint32_t erase_counts[FLASH_STORE_SECTORS];
+
+static bool head_open = false;   // head_sector has a valid header
+static uint32_t head_sector;     // sequence number of the newest sector
+static uint32_t next_page;       // sequence number of the next page to program
+
+static store_page_t buffer;      // page being filled in RAM
+static codec_encoder_t encoder;  // encodes into buffer.payload
+static flash_store_stats_t stats;
+
+/**
+ * @brief region offset of a page by sequence number
+ */
+static uint32_t page_offset(uint32_t page_seq)
+{
+    uint32_t sector = (page_seq / STORE_DATA_PAGES) % num_sectors;
+    uint32_t page = 1 + page_seq % STORE_DATA_PAGES;
+    return sector * FLASH_STORE_SECTOR_SIZE + page * FLASH_STORE_PAGE_SIZE;
+}
+
+/**
+ * @brief read and validate a sector header
+ *
+ * @return true if the header is intact
+ */
+static bool read_sector_header(uint32_t index, sector_header_t* header)
+{
+    if (!flash->read(index * FLASH_STORE_SECTOR_SIZE, header, sizeof(*header)))
+    {
+        return false;
+    }
+    return header->magic == SECTOR_MAGIC &&
+           header->crc == crc16_ccitt((const uint8_t*)header, offsetof(sector_header_t, crc));
+}
+
+/**
+ * @brief true if a page has never been programmed since its sector was erased
+ */
+static bool page_erased(uint32_t offset)
+{
+    uint8_t data[FLASH_STORE_PAGE_SIZE];
+
+    if (!flash->read(offset, data, sizeof(data)))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(data); i++)
+    {
+        if (data[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief erase the sector for a new sector sequence number and write its header
+ *
+ * @details The sector being reused holds the oldest data in the log
+ */
+static bool open_sector(uint32_t sector_seq)
+{
+    uint32_t index = sector_seq % num_sectors;
+    uint8_t page[FLASH_STORE_PAGE_SIZE];
+    sector_header_t header;
+
+    // an unreadable header means the wear history is unknown; count from here
+    uint32_t erase_count = read_sector_header(index, &header) ? header.erase_count + 1 : 1;
+
+    head_open = false;
+    if (!flash->erase_sector(index * FLASH_STORE_SECTOR_SIZE))
+    {
+        stats.write_errors++;
+        return false;
+    }
+    stats.sectors_erased++;
+    erase_counts[index] = erase_count;
+
+    header = (sector_header_t){
+        .magic = SECTOR_MAGIC,
+        .seq = sector_seq,
+        .erase_count = erase_count,
+        .reserved = 0xFFFF,
+    };
+    header.crc = crc16_ccitt((const uint8_t*)&header, offsetof(sector_header_t, crc));
+
+    memset(page, 0xFF, sizeof(page));
+    memcpy(page, &header, sizeof(header));
+    if (!flash->program_page(index * FLASH_STORE_SECTOR_SIZE, page))
+    {
+        stats.write_errors++;
+        return false;
+    }
+
+    head_sector = sector_seq;
+    head_open = true;
+    return true;
+}
+
+/**
+ * @brief find the head of the log
+ *
+ * @details Reads every sector header but only the pages of the newest
+ * sector. A page that is not erased counts as used even if its CRC is
+ * bad (a write cut short by power loss); appending resumes after it.
+ *
+ * @param backend flash region to use
+ *
+ * @return false if the backend region does not fit the store
+ */
+bool flash_store_init(const flash_backend_t* backend)
+{
+    sector_header_t header;
+    bool found = false;
+
+    flash = backend;
+    num_sectors = backend->size / FLASH_STORE_SECTOR_SIZE;
+    if (num_sectors < 2 || num_sectors > FLASH_STORE_SECTORS)
+    {
+        flash = NULL;
+        return false;
+    }
+
+    for (uint32_t i = 0; i < num_sectors; i++)
+    {
+        erase_counts[i] = 0;
+        if (!read_sector_header(i, &header) || header.seq % num_sectors != i)
+        {
+            continue;
+        }
+        erase_counts[i] = header.erase_count;
+        if (!found || (int32_t)(header.seq - head_sector) > 0)
+        {
+            head_sector = header.seq;
+            found = true;
+        }
+    }
+
+    codec_encoder_init(&encoder, buffer.payload, sizeof(buffer.payload));
+    head_open = found;
+    if (!found)
+    {
+        // blank or foreign region: start a fresh log
+        next_page = 0;
+        return true;
+    }
+
+    // first erased page in the head sector; a full sector leaves the
+    // next page in the following sector, opened on the first write
+    uint32_t page = 0;
+    while (page < STORE_DATA_PAGES &&
+           !page_erased(page_offset(head_sector * STORE_DATA_PAGES + page)))
+    {
+        page++;
+    }
+    next_page = head_sector * STORE_DATA_PAGES + page;
+    return true;
+}
+
+/**
+ * @brief program the RAM page buffer into the next page of the log
+ */
+static bool write_page(void)
+{
+    uint32_t sector_seq = next_page / STORE_DATA_PAGES;
+
+    if ((!head_open || sector_seq != head_sector) && !open_sector(sector_seq))
+    {
+        // drop the batch; the next one tries the sector again
+        codec_encoder_init(&encoder, buffer.payload, sizeof(buffer.payload));
+        return false;
+    }
+
+    buffer.magic = PAGE_MAGIC;
+    buffer.count = encoder.count;
+    buffer.seq = next_page;
+    buffer.crc = crc16_ccitt((const uint8_t*)&buffer, offsetof(store_page_t, crc));
+
+    // a failed page is skipped rather than retried in place
+    bool ok = flash->program_page(page_offset(next_page), &buffer);
+    next_page++;
+    codec_encoder_init(&encoder, buffer.payload, sizeof(buffer.payload));
+
+    if (!ok)
+    {
+        stats.write_errors++;
+        return false;
+    }
+    stats.pages_written++;
+    return true;
+}
+
+/**
+ * @brief add a sample, programming the page first if the sample no longer fits
+ *
+ * @param sample sample in centi-units
+ *
+ * @return false if the store is not initialized or a write failed
+ */
+bool flash_store_append(const sensor_sample_t* sample)
+{
+    if (flash == NULL)
+    {
+        return false;
+    }
+
+    if (codec_encode(&encoder, sample))
+    {
+        return true;
+    }
+
+    // page full: commit it and start the next block with this sample
+    bool ok = write_page();
+    codec_encode(&encoder, sample);
+    return ok;
+}
+
+/**
+ * @brief program a partly filled page now (e.g. before a planned power-off)
+ *
+ * @return true if nothing was buffered or the page was written
+ */
+bool flash_store_flush(void)
+{
+    if (flash == NULL || encoder.count == 0)
+    {
+        return flash != NULL;
+    }
+    return write_page();
+}
+
+/**
+ * @brief samples buffered in RAM, not yet in flash
+ */
+size_t flash_store_buffered(void)
+{
+    return encoder.count;
+}
+
+/**
+ * @brief sequence numbers of the oldest page still held and the next page
+ *
+ * @details Pages in [first, next) may still fail to read if they were cut
+ * short by power loss or their write failed
+ */
+void flash_store_page_range(uint32_t* first, uint32_t* next)
+{
+    uint32_t held = (num_sectors - 1) * STORE_DATA_PAGES + next_page % STORE_DATA_PAGES;
+
+    // a full head sector keeps its pages until the next one is opened
+    if (next_page % STORE_DATA_PAGES == 0)
+    {
+        held = num_sectors * STORE_DATA_PAGES;
+    }
+
+    *next = next_page;
+    *first = (next_page > held) ? next_page - held : 0;
+}
+
+/**
+ * @brief load one page and prepare to decode it
+ *
+ * @details The page is held in a static buffer until the next call, so
+ * there can be one reader at a time
+ *
+ * @param page_seq page sequence number, see flash_store_page_range()
+ * @param decoder decoder to set up on the page's block
+ * @param count location to store the number of samples in the block
+ *
+ * @return false if the page is missing or fails its CRC
+ */
+bool flash_store_open_page(uint32_t page_seq, codec_decoder_t* decoder, uint16_t* count)
+{
+    static store_page_t page;
+    uint32_t first;
+    uint32_t next;
+
+    flash_store_page_range(&first, &next);
+    if (flash == NULL || page_seq < first || page_seq >= next)
+    {
+        return false;
+    }
+
+    if (!flash->read(page_offset(page_seq), &page, sizeof(page)) ||
+        page.magic != PAGE_MAGIC || page.seq != page_seq ||
+        page.crc != crc16_ccitt((const uint8_t*)&page, offsetof(store_page_t, crc)))
+    {
+        stats.crc_errors++;
+        return false;
+    }
+
+    codec_decoder_init(decoder, page.payload, sizeof(page.payload));
+    *count = page.count;
+    return true;
+}
+
+/**
+ * @brief store counters, including the wear spread across sectors
+ */
+void flash_store_get_stats(flash_store_stats_t* out)
+{
+    *out = stats;
+    out->min_erase_count = UINT32_MAX;
+    out->max_erase_count = 0;
+
+    for (uint32_t i = 0; i < num_sectors; i++)
+    {
+        if (erase_counts[i] < out->min_erase_count)
+        {
+            out->min_erase_count = erase_counts[i];
+        }
+        if (erase_counts[i] > out->max_erase_count)
+        {
+            out->max_erase_count = erase_counts[i];
+        }
+    }
+    if (num_sectors == 0)
+    {
+        out->min_erase_count = 0;
+    }
+}
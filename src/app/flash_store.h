@@ -0,0 +1,54 @@
+/**
+ * @file flash_store.h
+ * @brief Append-only, log-structured sample store in flash
+ *
+ * Layout: the region is a circular log of sectors. Page 0 of each sector
+ * holds a sector header with an absolute sector sequence number and an
+ * erase count. The remaining pages each hold one batch of samples:
+ *
+ *   | magic u16 | count u16 | page seq u32 | encoded block ... | crc16 |
+ *
+ * Each payload is one self-contained sample_codec block, so every page
+ * decodes on its own. Samples are encoded into a RAM page buffer and the
+ * page is programmed once the next sample no longer fits, so flash is
+ * always written one whole page at a time. The page CRC is
+ * the commit marker: a page cut short by power loss fails the CRC and is
+ * skipped, never misread. Sectors are erased in strict rotation just
+ * before reuse, so every sector wears at the same rate.
+ *
+ * Page seq p always lives in sector (p / STORE_DATA_PAGES) % sectors, so
+ * the boot scan reads the sector headers, picks the newest one and checks
+ * only that sector's pages to find the head.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_codec.h"
+#include "sample_queue.h"
+#include "../drivers/flash_backend.h"
+
+#define STORE_PAGES_PER_SECTOR (FLASH_STORE_SECTOR_SIZE / FLASH_STORE_PAGE_SIZE)
+#define STORE_DATA_PAGES (STORE_PAGES_PER_SECTOR - 1)   // page 0 is the header
+#define STORE_PAGE_HEADER_SIZE 8
+#define STORE_PAGE_PAYLOAD (FLASH_STORE_PAGE_SIZE - STORE_PAGE_HEADER_SIZE - 2)
+
+typedef struct
+{
+    uint32_t pages_written;     // pages programmed since boot
+    uint32_t sectors_erased;    // sectors erased since boot
+    uint32_t write_errors;      // failed erase or program operations
+    uint32_t crc_errors;        // pages that failed verification on read
+    uint32_t min_erase_count;   // least-worn sector
+    uint32_t max_erase_count;   // most-worn sector
+} flash_store_stats_t;
+
+bool flash_store_init(const flash_backend_t* backend);
+bool flash_store_append(const sensor_sample_t* sample);
+bool flash_store_flush(void);
+size_t flash_store_buffered(void);
+void flash_store_page_range(uint32_t* first, uint32_t* next);
+bool flash_store_open_page(uint32_t page_seq, codec_decoder_t* decoder, uint16_t* count);
+void flash_store_get_stats(flash_store_stats_t* stats);
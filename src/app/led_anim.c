@@ -0,0 +1,292 @@
+/**
+ * @file led_anim.c
+ * @brief Frame-based LED strip animation: cross-fades, brightness, gamma
+ *
+ * Runs on core0 only: scenes are set from the UI task and frames rendered
+ * from the animation task, so no locking is needed. Every strip shows the
+ * same frame.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "led_anim.h"
+#include "led_strip.h"
+
+#define Q8_ONE 256
+
+// perceptual level to PWM duty, gamma 2.2
+// generated by scripts/gen_gamma_table.py
+static const uint8_t gamma_table[256] = {
+      0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   1,
+      1,   1,   1,   1,   1,   1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,
+      3,   3,   3,   3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   6,   6,   6,
+      6,   7,   7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  11,  11,  11,  12,
+     12,  13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,
+     20,  20,  21,  22,  22,  23,  23,  24,  25,  25,  26,  26,  27,  28,  28,  29,
+     30,  30,  31,  32,  33,  33,  34,  35,  35,  36,  37,  38,  39,  39,  40,  41,
+     42,  43,  43,  44,  45,  46,  47,  48,  49,  49,  50,  51,  52,  53,  54,  55,
+     56,  57,  58,  59,  60,  61,  62,  63,  64,  65,  66,  67,  68,  69,  70,  71,
+     73,  74,  75,  76,  77,  78,  79,  81,  82,  83,  84,  85,  87,  88,  89,  90,
+     91,  93,  94,  95,  97,  98,  99, 100, 102, 103, 105, 106, 107, 109, 110, 111,
+    113, 114, 116, 117, 119, 120, 121, 123, 124, 126, 127, 129, 130, 132, 133, 135,
+    137, 138, 140, 141, 143, 145, 146, 148, 149, 151, 153, 154, 156, 158, 159, 161,
+    163, 165, 166, 168, 170, 172, 173, 175, 177, 179, 181, 182, 184, 186, 188, 190,
+    192, 194, 196, 197, 199, 201, 203, 205, 207, 209, 211, 213, 215, 217, 219, 221,
+    223, 225, 227, 229, 231, 234, 236, 238, 240, 242, 244, 246, 248, 251, 253, 255,
+};
+
+// per pixel, perceptual 0xRRGGBB
+static uint32_t fade_from[LED_STRIP_MAX_PIXELS];   // frame when the fade started
+static uint32_t target[LED_STRIP_MAX_PIXELS];      // frame of the current scene
+static uint32_t shown[LED_STRIP_MAX_PIXELS];       // last rendered, before brightness
+
+static uint32_t scene_rgb = 0;
+static uint8_t scene_fill = 0;          // eighths of the strip
+static bool scene_alarm = false;
+static uint16_t built_length = 0;       // strip layout target[] was built for
+static uint8_t built_strips = 0;
+
+static uint32_t fade_start_ms = 0;
+static bool fading = false;
+static bool dirty = true;               // brightness or scene changed
+
+static uint16_t brightness = LED_ANIM_DEFAULT_BRIGHTNESS * Q8_ONE / 100;
+static uint8_t brightness_percent = LED_ANIM_DEFAULT_BRIGHTNESS;
+static led_alarm_effect_t alarm_effect = LED_ALARM_PULSE;
+
+static led_anim_stats_t stats;
+
+/**
+ * @brief fill target[] for the scene and the current strip length
+ */
+static void build_target(void)
+{
+    uint16_t length = led_strip_length();
+    uint16_t lit = (uint16_t)((scene_fill * length + 7) / 8);
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        target[i] = (i < lit) ? scene_rgb : 0;
+    }
+    built_length = length;
+    built_strips = led_strip_count();
+}
+
+/**
+ * @brief clear the strip state and render the first frame on the next pass
+ */
+void led_anim_init(void)
+{
+    memset(shown, 0, sizeof(shown));
+    memset(&stats, 0, sizeof(stats));
+    build_target();
+    memcpy(shown, target, sizeof(shown));
+    fading = false;
+    dirty = true;
+}
+
+/**
+ * @brief change what the strip shows, cross-fading from the current frame
+ *
+ * @param rgb perceptual color, 0xRRGGBB
+ * @param fill_eighths lit part of each strip, 0 to 8
+ * @param alarm apply the alarm effect
+ */
+void led_anim_set_scene(uint32_t rgb, uint8_t fill_eighths, bool alarm)
+{
+    if (fill_eighths > 8)
+    {
+        fill_eighths = 8;
+    }
+    if (rgb == scene_rgb && fill_eighths == scene_fill && alarm == scene_alarm)
+    {
+        return;
+    }
+
+    scene_rgb = rgb;
+    scene_fill = fill_eighths;
+    scene_alarm = alarm;
+
+    // fade from wherever the previous fade had got to
+    memcpy(fade_from, shown, sizeof(fade_from));
+    build_target();
+    fade_start_ms = to_ms_since_boot(get_absolute_time());
+    fading = true;
+    stats.fades++;
+}
+
+/**
+ * @brief interpolate two perceptual colors per channel
+ * @param t 0 (a) to Q8_ONE (b)
+ */
+static uint32_t lerp_rgb(uint32_t a, uint32_t b, int32_t t)
+{
+    uint32_t out = 0;
+
+    for (uint8_t shift = 0; shift < 24; shift += 8)
+    {
+        int32_t ca = (int32_t)((a >> shift) & 0xFF);
+        int32_t cb = (int32_t)((b >> shift) & 0xFF);
+        out |= (uint32_t)(ca + (((cb - ca) * t) >> 8)) << shift;
+    }
+    return out;
+}
+
+/**
+ * @brief scale a perceptual color and gamma-correct it for the strip
+ * @param level Q8 brightness, 0 to Q8_ONE
+ * @return 0xGGRRBB duty values
+ */
+static uint32_t to_strip_color(uint32_t rgb, uint32_t level)
+{
+    uint8_t r = gamma_table[(((rgb >> 16) & 0xFF) * level) >> 8];
+    uint8_t g = gamma_table[(((rgb >> 8) & 0xFF) * level) >> 8];
+    uint8_t b = gamma_table[((rgb & 0xFF) * level) >> 8];
+
+    return ((uint32_t)g << 16) | ((uint32_t)r << 8) | b;
+}
+
+/**
+ * @brief alarm brightness envelope at a point in time
+ * @return Q8 factor
+ */
+static uint32_t alarm_envelope(uint32_t now_ms)
+{
+    uint32_t phase = now_ms % LED_ANIM_ALARM_PERIOD_MS;
+    uint32_t half = LED_ANIM_ALARM_PERIOD_MS / 2;
+
+    switch (alarm_effect)
+    {
+    case LED_ALARM_BLINK:
+        return (phase < half) ? Q8_ONE : 0;
+
+    case LED_ALARM_PULSE:
+    {
+        // triangle from 1/4 up to full and back
+        uint32_t tri = (phase < half) ? phase : LED_ANIM_ALARM_PERIOD_MS - phase;
+        return Q8_ONE / 4 + tri * (Q8_ONE * 3 / 4) / half;
+    }
+
+    case LED_ALARM_SOLID:
+    default:
+        return Q8_ONE;
+    }
+}
+
+/**
+ * @brief build and queue one frame (animation task, every LED_ANIM_FRAME_US)
+ *
+ * @details Does nothing when no fade or alarm effect is running and
+ * nothing changed since the last frame
+ */
+void led_anim_render(void)
+{
+    uint32_t now_ms = to_ms_since_boot(get_absolute_time());
+    bool animated = scene_alarm && alarm_effect != LED_ALARM_SOLID;
+    uint16_t length = led_strip_length();
+
+    if (length != built_length || led_strip_count() != built_strips)
+    {
+        // strip reconfigured: its pixels were cleared, show the scene now
+        build_target();
+        memcpy(shown, target, sizeof(shown));
+        fading = false;
+        dirty = true;
+    }
+    if (!fading && !animated && !dirty)
+    {
+        stats.frames_idle++;
+        return;
+    }
+
+    uint32_t start = time_us_32();
+    int32_t t = Q8_ONE;
+    if (fading)
+    {
+        uint32_t elapsed = now_ms - fade_start_ms;
+        if (elapsed < LED_ANIM_FADE_MS)
+        {
+            t = (int32_t)(elapsed * Q8_ONE / LED_ANIM_FADE_MS);
+        }
+        else
+        {
+            fading = false;
+        }
+    }
+
+    uint32_t level = brightness;
+    if (scene_alarm)
+    {
+        level = (level * alarm_envelope(now_ms)) >> 8;
+    }
+
+    uint8_t strips = led_strip_count();
+    uint32_t last_rgb = 0;
+    uint32_t last_out = to_strip_color(0, level);
+
+    for (uint16_t i = 0; i < length; i++)
+    {
+        uint32_t rgb = (t < Q8_ONE) ? lerp_rgb(fade_from[i], target[i], t) : target[i];
+        shown[i] = rgb;
+
+        // runs of one color are the common case: convert each run once
+        if (rgb != last_rgb)
+        {
+            last_rgb = rgb;
+            last_out = to_strip_color(rgb, level);
+        }
+        for (uint8_t s = 0; s < strips; s++)
+        {
+            led_strip_set_pixel(s, i, last_out);
+        }
+    }
+    led_strip_light();
+    dirty = false;
+
+    uint32_t elapsed_us = time_us_32() - start;
+    stats.frames_rendered++;
+    stats.total_render_us += elapsed_us;
+    if (elapsed_us > stats.max_render_us)
+    {
+        stats.max_render_us = elapsed_us;
+    }
+}
+
+/**
+ * @brief global strip brightness, applied before gamma correction
+ * @param percent 0 to 100
+ */
+void led_anim_set_brightness(uint8_t percent)
+{
+    if (percent > 100)
+    {
+        percent = 100;
+    }
+    brightness_percent = percent;
+    brightness = (uint16_t)(percent * Q8_ONE / 100);
+    dirty = true;
+}
+
+uint8_t led_anim_brightness(void)
+{
+    return brightness_percent;
+}
+
+void led_anim_set_alarm_effect(led_alarm_effect_t effect)
+{
+    alarm_effect = effect;
+    dirty = true;   // a solid alarm needs one frame at full level
+}
+
+led_alarm_effect_t led_anim_alarm_effect(void)
+{
+    return alarm_effect;
+}
+
+/**
+ * @brief frame counters and render time of non-idle frames
+ */
+const led_anim_stats_t* led_anim_get_stats(void)
+{
+    return &stats;
+}
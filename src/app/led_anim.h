@@ -0,0 +1,53 @@
+/**
+ * @file led_anim.h
+ * @brief Frame-based LED strip animation: cross-fades, brightness, gamma
+ *
+ * The UI sets a scene (a color and how much of the strip it fills) at the
+ * sample rate; a periodic scheduler task renders frames at LED_ANIM_FPS,
+ * independent of that rate. A scene change cross-fades from the frame on
+ * the strip to the new one over LED_ANIM_FADE_MS, and an active alarm
+ * pulses or blinks the strip.
+ *
+ * Colors are given as perceptual 0xRRGGBB and interpolated in that space.
+ * Each frame scales them by the global brightness and maps them through a
+ * gamma table to the GRB duty values the WS2812 expects. All integer math.
+ *
+ * When nothing is fading or pulsing a frame costs one comparison; the
+ * rendering cost of the other frames is kept in led_anim_stats_t.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define LED_ANIM_FPS 50
+#define LED_ANIM_FRAME_US (1000000 / LED_ANIM_FPS)
+#define LED_ANIM_FADE_MS 600
+#define LED_ANIM_ALARM_PERIOD_MS 1200   // one pulse or blink cycle
+#define LED_ANIM_DEFAULT_BRIGHTNESS 30  // percent
+
+typedef enum
+{
+    LED_ALARM_SOLID,    // steady
+    LED_ALARM_PULSE,    // triangle wave between 25 % and full brightness
+    LED_ALARM_BLINK     // on and off, half a period each
+} led_alarm_effect_t;
+
+typedef struct
+{
+    uint32_t frames_rendered;
+    uint32_t frames_idle;       // nothing changed, no frame built
+    uint32_t fades;             // scene changes
+    uint32_t max_render_us;
+    uint64_t total_render_us;   // over rendered frames
+} led_anim_stats_t;
+
+void led_anim_init(void);
+void led_anim_render(void);
+void led_anim_set_scene(uint32_t rgb, uint8_t fill_eighths, bool alarm);
+void led_anim_set_brightness(uint8_t percent);
+uint8_t led_anim_brightness(void);
+void led_anim_set_alarm_effect(led_alarm_effect_t effect);
+led_alarm_effect_t led_anim_alarm_effect(void);
+const led_anim_stats_t* led_anim_get_stats(void);
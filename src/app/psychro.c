@@ -0,0 +1,281 @@
+/**
+ * @file psychro.c
+ * @brief Derived psychrometric metrics in fixed point
+ */
+
+#include <stdbool.h>
+#include "fixed_point.h"
+#include "psychro.h"
+
+#define SVP_MIN_C -60
+#define SVP_MAX_C 85
+#define SVP_ENTRIES (SVP_MAX_C - SVP_MIN_C + 1)
+
+#define HUMIDITY_MAX 10000      // centi-percent
+#define KELVIN_OFFSET 27315     // centi-degrees
+
+// saturation vapour pressure in mPa, -60 to 85 C in 1 C steps
+// generated by scripts/gen_svp_table.py
+static const uint32_t svp_table[SVP_ENTRIES] = {
+    1901u, 2158u, 2447u, 2771u, 3134u, 3539u,
+    3992u, 4497u, 5060u, 5686u, 6382u, 7155u,
+    8011u, 8960u, 10010u, 11171u, 12452u, 13865u,
+    15423u, 17137u, 19021u, 21092u, 23364u, 25855u,
+    28584u, 31571u, 34836u, 38403u, 42297u, 46543u,
+    51169u, 56205u, 61683u, 67636u, 74102u, 81117u,
+    88723u, 96964u, 105885u, 115534u, 125965u, 137232u,
+    149392u, 162508u, 176645u, 191871u, 208259u, 225886u,
+    244833u, 265184u, 287031u, 310468u, 335593u, 362514u,
+    391339u, 422185u, 455173u, 490431u, 528093u, 568301u,
+    611200u, 656946u, 705700u, 757632u, 812918u, 871743u,
+    934300u, 1000793u, 1071430u, 1146433u, 1226030u, 1310462u,
+    1399976u, 1494834u, 1595306u, 1701672u, 1814226u, 1933273u,
+    2059129u, 2192122u, 2332596u, 2480904u, 2637415u, 2802511u,
+    2976588u, 3160057u, 3353343u, 3556889u, 3771149u, 3996598u,
+    4233724u, 4483033u, 4745050u, 5020314u, 5309386u, 5612842u,
+    5931279u, 6265314u, 6615581u, 6982737u, 7367458u, 7770442u,
+    8192406u, 8634094u, 9096266u, 9579710u, 10085234u, 10613672u,
+    11165880u, 11742740u, 12345158u, 12974067u, 13630424u, 14315214u,
+    15029448u, 15774163u, 16550428u, 17359335u, 18202007u, 19079598u,
+    19993287u, 20944289u, 21933843u, 22963224u, 24033735u, 25146714u,
+    26303529u, 27505581u, 28754305u, 30051169u, 31397675u, 32795361u,
+    34245797u, 35750593u, 37311389u, 38929867u, 40607743u, 42346769u,
+    44148737u, 46015477u, 47948855u, 49950778u, 52023192u, 54168084u,
+    56387477u, 58683439u,
+};
+
+/**
+ * @brief clamp temperature to the table and humidity to 0-100 %
+ */
+static void clamp_inputs(int32_t* temp, int32_t* humidity)
+{
+    if (*temp < SVP_MIN_C * 100)
+        *temp = SVP_MIN_C * 100;
+    if (*temp > SVP_MAX_C * 100)
+        *temp = SVP_MAX_C * 100;
+    if (*humidity < 0)
+        *humidity = 0;
+    if (*humidity > HUMIDITY_MAX)
+        *humidity = HUMIDITY_MAX;
+}
+
+/**
+ * @brief saturation vapour pressure, interpolated between table entries
+ *
+ * @param temp centi-degrees celsius, within the table
+ *
+ * @return pressure in millipascals
+ */
+static uint32_t svp_mpa(int32_t temp)
+{
+    int32_t offset = temp - SVP_MIN_C * 100;
+    uint32_t i = (uint32_t)offset / 100;
+    uint32_t frac = (uint32_t)offset % 100;
+
+    if (i >= SVP_ENTRIES - 1)
+    {
+        return svp_table[SVP_ENTRIES - 1];
+    }
+    return svp_table[i] + (uint32_t)(((uint64_t)(svp_table[i + 1] - svp_table[i]) * frac + 50) / 100);
+}
+
+/**
+ * @brief actual vapour pressure in millipascals
+ */
+static uint32_t vapour_mpa(int32_t temp, int32_t humidity)
+{
+    return (uint32_t)(((uint64_t)svp_mpa(temp) * (uint32_t)humidity + HUMIDITY_MAX / 2) / HUMIDITY_MAX);
+}
+
+/**
+ * @brief dew point: the temperature whose saturation pressure equals the
+ * actual vapour pressure
+ *
+ * @param temp temperature in centi-degrees celsius
+ * @param humidity relative humidity in centi-percent
+ *
+ * @return dew point in centi-degrees celsius, no lower than the table
+ * minimum (-60 C)
+ */
+int32_t psychro_dew_point(int32_t temp, int32_t humidity)
+{
+    clamp_inputs(&temp, &humidity);
+    uint32_t e = vapour_mpa(temp, humidity);
+
+    if (e <= svp_table[0])
+    {
+        return SVP_MIN_C * 100;
+    }
+
+    // last entry not above e; the table is strictly increasing
+    uint32_t lo = 0;
+    uint32_t hi = SVP_ENTRIES - 1;
+    while (hi - lo > 1)
+    {
+        uint32_t mid = (lo + hi) / 2;
+        if (svp_table[mid] <= e)
+            lo = mid;
+        else
+            hi = mid;
+    }
+
+    uint32_t span = svp_table[hi] - svp_table[lo];
+    int32_t frac = (int32_t)(((uint64_t)(e - svp_table[lo]) * 100 + span / 2) / span);
+    int32_t dew_point = (SVP_MIN_C + (int32_t)lo) * 100 + frac;
+
+    // saturated air rounds to a hair above the air temperature
+    return (dew_point > temp) ? temp : dew_point;
+}
+
+/**
+ * @brief absolute humidity from the ideal gas law for water vapour
+ *
+ * @param temp temperature in centi-degrees celsius
+ * @param humidity relative humidity in centi-percent
+ *
+ * @return water vapour density in centi-grams per cubic metre
+ */
+int32_t psychro_abs_humidity(int32_t temp, int32_t humidity)
+{
+    clamp_inputs(&temp, &humidity);
+
+    // rho = e / (Rv * T), Rv = 461.5 J/(kg K); mPa and centi-kelvin in,
+    // centi-g/m3 out
+    uint64_t kelvin = (uint64_t)(temp + KELVIN_OFFSET);
+    uint64_t den = 4615 * kelvin;
+    return (int32_t)(((uint64_t)vapour_mpa(temp, humidity) * 100000 + den / 2) / den);
+}
+
+/**
+ * @brief integer square root (floor)
+ */
+static uint32_t isqrt32(uint32_t n)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+
+    while (bit > n)
+        bit >>= 2;
+    while (bit != 0)
+    {
+        if (n >= root + bit)
+        {
+            n -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+/**
+ * @brief signed division rounding half away from zero
+ */
+static int64_t div_round64(int64_t num, int64_t den)
+{
+    return (num >= 0) ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+// Rothfusz regression coefficients, scaled by 10^8
+static const int64_t rothfusz[9] = {
+    -4237900000LL,   // 1
+    204901523LL,     // T
+    1014333127LL,    // RH
+    -22475541LL,     // T RH
+    -683783LL,       // T^2
+    -5481717LL,      // RH^2
+    122874LL,        // T^2 RH
+    85282LL,         // T RH^2
+    -199LL,          // T^2 RH^2
+};
+
+/**
+ * @brief NWS heat index in centi-degrees fahrenheit
+ *
+ * @details The branch tests use five times the fahrenheit temperature,
+ * which is exact for a celsius input, so rounding never moves a sample
+ * across one of the algorithm's discontinuities
+ *
+ * @param temp temperature in centi-degrees celsius
+ * @param r relative humidity in centi-percent
+ */
+static int32_t heat_index_f(int32_t temp, int32_t r)
+{
+    int64_t t5 = 9LL * temp + 16000;   // 5 x centi-degrees fahrenheit
+    int32_t t = (int32_t)div_round64(t5, 5);
+
+    // Steadman's simple fit, 0.5 * (T + 61 + 1.2 (T - 68) + 0.094 RH), is
+    // used while its average with T is below 80 F
+    int64_t simple = 2200 * t5 - 10300000 + 470LL * r;   // x10000
+    if (simple + 2000 * t5 < 160000000LL)
+    {
+        return (int32_t)div_round64(simple, 10000);
+    }
+
+    // the regression is only valid up to about 140 F; also bounds the terms
+    if (t > 14000)
+        t = 14000;
+
+    // each term is coefficient * T^a * RH^b with T, RH in centi-units, so
+    // it carries 10^8 * 100^(a+b) of scale
+    int64_t t2 = (int64_t)t * t;
+    int64_t r2 = (int64_t)r * r;
+    int64_t sum = rothfusz[0] * 100
+                + rothfusz[1] * t
+                + rothfusz[2] * r
+                + div_round64(rothfusz[3] * t * r, 100)
+                + div_round64(rothfusz[4] * t2, 100)
+                + div_round64(rothfusz[5] * r2, 100)
+                + div_round64(rothfusz[6] * t2 * r, 10000)
+                + div_round64(rothfusz[7] * t * r2, 10000)
+                + div_round64(rothfusz[8] * t2 * r2, 1000000);
+    int32_t hi = (int32_t)div_round64(sum, 100000000);
+
+    if (r < 1300 && t5 >= 40000 && t5 <= 56000)
+    {
+        // dry air: subtract ((13 - RH) / 4) * sqrt((17 - |T - 95|) / 17)
+        int32_t d = (t > 9500) ? t - 9500 : 9500 - t;
+        uint32_t root = isqrt32((uint32_t)(1700 - d) * 1000000u / 1700);   // x1000
+        hi -= (int32_t)(((int64_t)(1300 - r) * root + 2000) / 4000);
+    }
+    else if (r > 8500 && t5 >= 40000 && t5 <= 43500)
+    {
+        // humid air: add ((RH - 85) / 10) * ((87 - T) / 5)
+        hi += (r - 8500) * (8700 - t) / 5000;
+    }
+    return hi;
+}
+
+/**
+ * @brief heat index (apparent temperature)
+ *
+ * @param temp temperature in centi-degrees celsius
+ * @param humidity relative humidity in centi-percent
+ *
+ * @return heat index in centi-degrees celsius; below about 27 C it stays
+ * close to the air temperature
+ */
+int32_t psychro_heat_index(int32_t temp, int32_t humidity)
+{
+    clamp_inputs(&temp, &humidity);
+
+    return fahrenheit_to_celsius_centi(heat_index_f(temp, humidity));
+}
+
+/**
+ * @brief all derived metrics for one sample
+ *
+ * @param temp temperature in centi-degrees celsius
+ * @param humidity relative humidity in centi-percent
+ * @param out location to store the metrics
+ */
+void psychro_compute(int32_t temp, int32_t humidity, psychro_t* out)
+{
+    out->dew_point = psychro_dew_point(temp, humidity);
+    out->heat_index = psychro_heat_index(temp, humidity);
+    out->abs_humidity = psychro_abs_humidity(temp, humidity);
+}
@@ -0,0 +1,46 @@
+/**
+ * @file psychro.h
+ * @brief Derived psychrometric metrics in fixed point
+ *
+ * Dew point and absolute humidity come from a saturation vapour pressure
+ * table (Magnus formula, 1 C steps) with linear interpolation; the dew
+ * point inverts the same table by binary search. Heat index is the NWS
+ * Rothfusz regression evaluated in integer arithmetic. No floating point
+ * or libm is used.
+ *
+ * Checked against a double-precision reference (Magnus with exp/log,
+ * NWS heat index) over -40 to 80 C and 0 to 100 %RH by
+ * tests/host/test_psychro.c:
+ *  - dew point: within 0.03 C (RH >= 1 %; drier air clamps to -60 C)
+ *  - absolute humidity: within 0.15 % of the value, plus output rounding
+ *    (the 1 C interpolation is worst in the cold end)
+ *  - heat index: within 0.05 C
+ * The reference and the table use the same Magnus constants, so these
+ * bound the fixed-point and interpolation error, not the formula's own.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+// Selectable derived metrics, as a bitmask for telemetry fields
+typedef enum
+{
+    PSYCHRO_DEW_POINT = 1 << 0,
+    PSYCHRO_HEAT_INDEX = 1 << 1,
+    PSYCHRO_ABS_HUMIDITY = 1 << 2,
+} psychro_metric_t;
+
+#define PSYCHRO_ALL (PSYCHRO_DEW_POINT | PSYCHRO_HEAT_INDEX | PSYCHRO_ABS_HUMIDITY)
+
+typedef struct
+{
+    int32_t dew_point;      // centi-degrees celsius
+    int32_t heat_index;     // centi-degrees celsius
+    int32_t abs_humidity;   // centi-grams per cubic metre
+} psychro_t;
+
+int32_t psychro_dew_point(int32_t temp, int32_t humidity);
+int32_t psychro_heat_index(int32_t temp, int32_t humidity);
+int32_t psychro_abs_humidity(int32_t temp, int32_t humidity);
+void psychro_compute(int32_t temp, int32_t humidity, psychro_t* out);
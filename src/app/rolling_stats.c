@@ -0,0 +1,215 @@
+/**
+ * @file rolling_stats.c
+ * @brief Incremental rolling statistics of the sample stream
+ */
+
+#include "rolling_stats.h"
+
+#define FRAC_HALF (1 << (ROLLING_FRAC_BITS - 1))
+
+// The Welford mean keeps 32 fraction bits so its per-sample update,
+// (x - mean) / n, does not round to zero on long runs
+#define MEAN_FRAC_BITS 32
+#define MEAN_TO_Q_SHIFT (MEAN_FRAC_BITS - ROLLING_FRAC_BITS)
+
+// Monotonic deque over the last ROLLING_WINDOW samples. The min deque
+// holds increasing values, the max deque decreasing ones; the front is
+// the current extreme.
+typedef struct
+{
+    uint32_t seq[ROLLING_WINDOW];
+    int32_t value[ROLLING_WINDOW];
+    uint8_t front;
+    uint8_t len;
+} deque_t;
+
+typedef struct
+{
+    int32_t last;
+    int32_t ema_q;      // EMA with ROLLING_FRAC_BITS fraction bits
+    deque_t min;
+    deque_t max;
+    uint32_t n;         // Welford sample count
+    int64_t mean_q32;   // Welford mean with MEAN_FRAC_BITS fraction bits
+    int64_t m2_q;       // sum of squared deviations, 2 * ROLLING_FRAC_BITS fraction bits
+} channel_t;
+
+static channel_t channels[ROLLING_CHANNELS];
+static uint32_t seq = 0;   // samples seen, for window expiry
+
+/**
+ * @brief index of the i-th entry from the front
+ */
+static uint8_t deque_at(const deque_t* dq, uint8_t i)
+{
+    return (uint8_t)((dq->front + i) % ROLLING_WINDOW);
+}
+
+/**
+ * @brief push a value, dropping expired entries and entries it dominates
+ *
+ * @param dq deque to update
+ * @param value new value
+ * @param keep_less true for the min deque, false for the max deque
+ */
+static void deque_push(deque_t* dq, int32_t value, bool keep_less)
+{
+    // entries that can never be the extreme again leave from the back
+    while (dq->len > 0)
+    {
+        int32_t back = dq->value[deque_at(dq, dq->len - 1)];
+        if (keep_less ? back < value : back > value)
+        {
+            break;
+        }
+        dq->len--;
+    }
+
+    // the front entry leaves once it falls out of the window
+    if (dq->len > 0 && seq - dq->seq[dq->front] >= ROLLING_WINDOW)
+    {
+        dq->front = deque_at(dq, 1);
+        dq->len--;
+    }
+
+    uint8_t slot = deque_at(dq, dq->len);
+    dq->seq[slot] = seq;
+    dq->value[slot] = value;
+    dq->len++;
+}
+
+/**
+ * @brief integer square root of a 64-bit value
+ */
+static uint32_t isqrt64(uint64_t value)
+{
+    uint64_t root = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)root;
+}
+
+/**
+ * @brief round a value with ROLLING_FRAC_BITS fraction bits to centi-units
+ */
+static int32_t from_q(int32_t value_q)
+{
+    return (value_q >= 0) ? (value_q + FRAC_HALF) >> ROLLING_FRAC_BITS
+                          : -((-value_q + FRAC_HALF) >> ROLLING_FRAC_BITS);
+}
+
+/**
+ * @brief divide rounding half away from zero, so the mean has no drift
+ */
+static int64_t div_round(int64_t num, int64_t den)
+{
+    return (num >= 0) ? (num + den / 2) / den : (num - den / 2) / den;
+}
+
+/**
+ * @brief narrow a MEAN_FRAC_BITS value to ROLLING_FRAC_BITS, rounding to nearest
+ */
+static int32_t q32_to_q(int64_t value_q32)
+{
+    return (int32_t)((value_q32 + (1LL << (MEAN_TO_Q_SHIFT - 1))) >> MEAN_TO_Q_SHIFT);
+}
+
+static void channel_add(channel_t* ch, int32_t value)
+{
+    int32_t value_q = value * (1 << ROLLING_FRAC_BITS);
+
+    ch->last = value;
+
+    // EMA: ema += (x - ema) * alpha
+    if (seq == 0)
+    {
+        ch->ema_q = value_q;
+    }
+    else
+    {
+        ch->ema_q += (value_q - ch->ema_q) / (1 << ROLLING_EMA_SHIFT);
+    }
+
+    deque_push(&ch->min, value, true);
+    deque_push(&ch->max, value, false);
+
+    // Welford: stable running mean and sum of squared deviations. The
+    // deviations are narrowed to ROLLING_FRAC_BITS so their product fits
+    ch->n++;
+    int64_t value_q32 = (int64_t)value * (1LL << MEAN_FRAC_BITS);
+    int32_t delta = value_q - q32_to_q(ch->mean_q32);
+    ch->mean_q32 += div_round(value_q32 - ch->mean_q32, (int64_t)ch->n);
+    ch->m2_q += (int64_t)delta * (value_q - q32_to_q(ch->mean_q32));
+}
+
+/**
+ * @brief add a sample to both channels
+ *
+ * @param sample sample in centi-units
+ */
+void rolling_stats_add(const sensor_sample_t* sample)
+{
+    channel_add(&channels[ROLLING_TEMP], sample->temp);
+    channel_add(&channels[ROLLING_HUMIDITY], sample->humidity);
+    seq++;
+}
+
+/**
+ * @brief restart the running mean and variance; EMA and window carry on
+ */
+void rolling_stats_reset(void)
+{
+    for (uint8_t i = 0; i < ROLLING_CHANNELS; i++)
+    {
+        channels[i].n = 0;
+        channels[i].mean_q32 = 0;
+        channels[i].m2_q = 0;
+    }
+}
+
+/**
+ * @brief current statistics of one channel
+ *
+ * @return false until the first sample has arrived
+ */
+bool rolling_stats_get(rolling_channel_t channel, rolling_summary_t* out)
+{
+    if (channel >= ROLLING_CHANNELS || seq == 0)
+    {
+        return false;
+    }
+
+    const channel_t* ch = &channels[channel];
+    out->last = ch->last;
+    out->ema = from_q(ch->ema_q);
+    out->min = ch->min.value[ch->min.front];
+    out->max = ch->max.value[ch->max.front];
+    out->count = ch->n;
+    out->mean = from_q(q32_to_q(ch->mean_q32));
+    out->stddev = 0;
+
+    if (ch->n > 1)
+    {
+        // sqrt of a 2F-bit variance has F fraction bits
+        uint32_t sd_q = isqrt64((uint64_t)(ch->m2_q / (ch->n - 1)));
+        out->stddev = from_q((int32_t)sd_q);
+    }
+    return true;
+}
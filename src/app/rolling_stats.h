@@ -0,0 +1,47 @@
+/**
+ * @file rolling_stats.h
+ * @brief Incremental rolling statistics of the sample stream
+ *
+ * Per channel, every sample updates in O(1) (amortized for the window):
+ *  - an exponential moving average, alpha = 1 / 2^ROLLING_EMA_SHIFT
+ *  - min and max over the last ROLLING_WINDOW samples, kept in monotonic
+ *    deques so no buffer is rescanned
+ *  - Welford running mean and variance since the last reset
+ *
+ * Everything is fixed-point: values are centi-units, the EMA and the
+ * Welford sum of squares carry ROLLING_FRAC_BITS extra fraction bits and
+ * the Welford mean carries 32, so it keeps tracking over months of samples.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+#define ROLLING_WINDOW 60      // samples in the min/max window
+#define ROLLING_EMA_SHIFT 3    // alpha = 1/8
+#define ROLLING_FRAC_BITS 8
+
+typedef enum
+{
+    ROLLING_TEMP,
+    ROLLING_HUMIDITY,
+    ROLLING_CHANNELS
+} rolling_channel_t;
+
+// Snapshot of one channel, in centi-units
+typedef struct
+{
+    int32_t last;       // newest sample
+    int32_t ema;        // exponential moving average
+    int32_t min;        // window minimum
+    int32_t max;        // window maximum
+    int32_t mean;       // mean since reset
+    int32_t stddev;     // sample standard deviation since reset
+    uint32_t count;     // samples since reset
+} rolling_summary_t;
+
+void rolling_stats_add(const sensor_sample_t* sample);
+void rolling_stats_reset(void);
+bool rolling_stats_get(rolling_channel_t channel, rolling_summary_t* out);
@@ -0,0 +1,183 @@
+/**
+ * @file rrd.c
+ * @brief Round-robin aggregation tiers: per-second, per-minute and per-hour
+ */
+
+#include "rrd.h"
+
+typedef struct
+{
+    uint32_t period_ms;
+    uint16_t size;          // buckets in the ring
+    rrd_bucket_t* ring;
+    uint32_t filled;        // buckets written, including the open one (capped at size)
+    uint32_t index;         // periods since boot to the open bucket, free-running
+    uint32_t open_ms;       // start of the open bucket, in wrapping ms since boot
+    int32_t temp_sum;       // running sums of the open bucket
+    int32_t humidity_sum;
+} rrd_tier_state_t;
+
+static rrd_bucket_t raw_ring[RRD_RAW_BUCKETS];
+static rrd_bucket_t minute_ring[RRD_MINUTE_BUCKETS];
+static rrd_bucket_t hour_ring[RRD_HOUR_BUCKETS];
+
+static rrd_tier_state_t tiers[RRD_TIER_COUNT] = {
+    [RRD_RAW] = { .period_ms = 1000, .size = RRD_RAW_BUCKETS, .ring = raw_ring },
+    [RRD_MINUTE] = { .period_ms = 60 * 1000, .size = RRD_MINUTE_BUCKETS, .ring = minute_ring },
+    [RRD_HOUR] = { .period_ms = 60 * 60 * 1000, .size = RRD_HOUR_BUCKETS, .ring = hour_ring },
+};
+
+/**
+ * @brief mean of a bucket's samples, rounded half away from zero
+ */
+static int16_t bucket_mean(int32_t sum, uint16_t count)
+{
+    int32_t half = count / 2;
+    return (int16_t)((sum >= 0) ? (sum + half) / count : (sum - half) / count);
+}
+
+/**
+ * @brief start an empty bucket
+ */
+static void open_bucket(rrd_tier_state_t* tier, uint32_t index)
+{
+    tier->index = index;
+    tier->ring[index % tier->size] = (rrd_bucket_t){ 0 };
+    tier->temp_sum = 0;
+    tier->humidity_sum = 0;
+}
+
+/**
+ * @brief add one sample to one tier
+ */
+static void tier_add(rrd_tier_state_t* tier, const sensor_sample_t* sample)
+{
+    // timestamp_ms wraps after 49.7 days, so the period number is
+    // advanced by the wrapped time since the open bucket started rather
+    // than recomputed from the timestamp
+    uint32_t elapsed = sample->timestamp_ms - tier->open_ms;
+
+    if (tier->filled == 0)
+    {
+        open_bucket(tier, sample->timestamp_ms / tier->period_ms);
+        tier->open_ms = tier->index * tier->period_ms;
+        tier->filled = 1;
+    }
+    else if ((int32_t)elapsed >= (int32_t)tier->period_ms)
+    {
+        uint32_t gap = elapsed / tier->period_ms;
+        uint32_t index = tier->index + gap;
+
+        rrd_bucket_t* closed = &tier->ring[tier->index % tier->size];
+        if (closed->count > 0)
+        {
+            closed->temp_mean = bucket_mean(tier->temp_sum, closed->count);
+            closed->humidity_mean = bucket_mean(tier->humidity_sum, closed->count);
+        }
+
+        // periods without samples become empty buckets; a gap longer
+        // than the ring only needs to clear the ring once
+        uint32_t steps = (gap > tier->size) ? tier->size : gap;
+        for (uint32_t i = steps; i > 0; i--)
+        {
+            open_bucket(tier, index - i + 1);
+        }
+        tier->open_ms += gap * tier->period_ms;
+
+        tier->filled += gap;
+        if (tier->filled > tier->size)
+        {
+            tier->filled = tier->size;
+        }
+    }
+
+    // a sample older than the open bucket (clock anomaly) joins it
+    rrd_bucket_t* bucket = &tier->ring[tier->index % tier->size];
+    int16_t temp = (int16_t)sample->temp;
+    int16_t humidity = (int16_t)sample->humidity;
+
+    if (bucket->count == 0 || temp < bucket->temp_min)
+    {
+        bucket->temp_min = temp;
+    }
+    if (bucket->count == 0 || temp > bucket->temp_max)
+    {
+        bucket->temp_max = temp;
+    }
+    if (bucket->count == 0 || humidity < bucket->humidity_min)
+    {
+        bucket->humidity_min = humidity;
+    }
+    if (bucket->count == 0 || humidity > bucket->humidity_max)
+    {
+        bucket->humidity_max = humidity;
+    }
+
+    if (bucket->count < UINT16_MAX)
+    {
+        bucket->count++;
+        tier->temp_sum += temp;
+        tier->humidity_sum += humidity;
+    }
+}
+
+/**
+ * @brief add a sample to every tier, O(1) per tier
+ *
+ * @param sample sample in centi-units
+ */
+void rrd_add(const sensor_sample_t* sample)
+{
+    for (uint8_t i = 0; i < RRD_TIER_COUNT; i++)
+    {
+        tier_add(&tiers[i], sample);
+    }
+}
+
+/**
+ * @brief buckets held in a tier, including the open one
+ */
+size_t rrd_count(rrd_tier_t tier)
+{
+    return (tier < RRD_TIER_COUNT) ? tiers[tier].filled : 0;
+}
+
+/**
+ * @brief length of a tier's period
+ */
+uint32_t rrd_period_ms(rrd_tier_t tier)
+{
+    return (tier < RRD_TIER_COUNT) ? tiers[tier].period_ms : 0;
+}
+
+/**
+ * @brief read one bucket
+ *
+ * @param tier tier to read
+ * @param age 0 for the open bucket, 1 for the one before it, ...
+ * @param out location to store the bucket; the open bucket's mean is
+ * computed from its running sums
+ * @param start_s location to store the period's start, seconds since boot
+ *
+ * @return false if the tier does not hold that bucket
+ */
+bool rrd_get(rrd_tier_t tier, size_t age, rrd_bucket_t* out, uint32_t* start_s)
+{
+    if (tier >= RRD_TIER_COUNT || age >= tiers[tier].filled)
+    {
+        return false;
+    }
+
+    const rrd_tier_state_t* state = &tiers[tier];
+    uint32_t index = state->index - (uint32_t)age;
+
+    *out = state->ring[index % state->size];
+    *start_s = index * (state->period_ms / 1000);
+
+    if (age == 0 && out->count > 0)
+    {
+        out->temp_mean = bucket_mean(state->temp_sum, out->count);
+        out->humidity_mean = bucket_mean(state->humidity_sum, out->count);
+    }
+    return true;
+}
@@ -0,0 +1,50 @@
+/**
+ * @file rrd.h
+ * @brief Round-robin aggregation tiers: per-second, per-minute and per-hour
+ *
+ * Every sample updates the open bucket of each tier in O(1): min, max,
+ * count and a running sum for the mean. When a sample falls into a later
+ * period, the open bucket is closed (its mean stored) and the next one
+ * opened. Periods with no samples become empty buckets (count 0). Each
+ * tier is a fixed ring, so the oldest bucket is overwritten.
+ *
+ * Buckets are aligned to time since boot; like the RAM history the tiers
+ * start empty after a reset. Each tier counts its periods itself, so the
+ * tiers keep going across the 49.7-day wrap of the ms timestamp.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+#define RRD_RAW_BUCKETS 120      // 1 s buckets: 2 minutes
+#define RRD_MINUTE_BUCKETS 240   // 1 min buckets: 4 hours
+#define RRD_HOUR_BUCKETS 744     // 1 h buckets: 31 days
+
+typedef enum
+{
+    RRD_RAW,
+    RRD_MINUTE,
+    RRD_HOUR,
+    RRD_TIER_COUNT
+} rrd_tier_t;
+
+// One aggregated period, in centi-units (14 bytes)
+typedef struct
+{
+    uint16_t count;          // samples in the period, 0 if none arrived
+    int16_t temp_min;
+    int16_t temp_mean;
+    int16_t temp_max;
+    int16_t humidity_min;
+    int16_t humidity_mean;
+    int16_t humidity_max;
+} rrd_bucket_t;
+
+void rrd_add(const sensor_sample_t* sample);
+size_t rrd_count(rrd_tier_t tier);
+uint32_t rrd_period_ms(rrd_tier_t tier);
+bool rrd_get(rrd_tier_t tier, size_t age, rrd_bucket_t* out, uint32_t* start_s);
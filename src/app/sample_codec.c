@@ -0,0 +1,272 @@
+/**
+ * @file sample_codec.c
+ * @brief Streaming bit-packed codec for the sample time series
+ *
+ * Builds without the Pico SDK so the flash store can run on the host
+ */
+
+#include <string.h>
+#include "sample_codec.h"
+
+/**
+ * @brief map a signed value onto small unsigned ones: 0, -1, 1, -2 ... -> 0, 1, 2, 3 ...
+ */
+static uint32_t zigzag(int32_t value)
+{
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static int32_t unzigzag(uint32_t value)
+{
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+/**
+ * @brief bits the prefix code needs for a zig-zag value
+ */
+static uint32_t code_bits(uint32_t zz)
+{
+    if (zz == 0)
+    {
+        return 1;
+    }
+    if (zz < 16)
+    {
+        return 2 + 4;
+    }
+    if (zz < 128)
+    {
+        return 3 + 7;
+    }
+    if (zz < 4096)
+    {
+        return 4 + 12;
+    }
+    return 4 + 32;
+}
+
+/**
+ * @brief append the low n bits of value, most significant first
+ */
+static void put_bits(codec_encoder_t* enc, uint32_t value, uint8_t n)
+{
+    while (n > 0)
+    {
+        n--;
+        if ((value >> n) & 1)
+        {
+            enc->buf[enc->bit_pos >> 3] |= (uint8_t)(0x80 >> (enc->bit_pos & 7));
+        }
+        enc->bit_pos++;
+    }
+}
+
+static void put_code(codec_encoder_t* enc, uint32_t zz)
+{
+    if (zz == 0)
+    {
+        put_bits(enc, 0x0, 1);
+    }
+    else if (zz < 16)
+    {
+        put_bits(enc, 0x2, 2);
+        put_bits(enc, zz, 4);
+    }
+    else if (zz < 128)
+    {
+        put_bits(enc, 0x6, 3);
+        put_bits(enc, zz, 7);
+    }
+    else if (zz < 4096)
+    {
+        put_bits(enc, 0xE, 4);
+        put_bits(enc, zz, 12);
+    }
+    else
+    {
+        put_bits(enc, 0xF, 4);
+        put_bits(enc, zz, 32);
+    }
+}
+
+/**
+ * @brief start a new block in buf
+ *
+ * @param enc encoder state
+ * @param buf block storage; cleared here
+ * @param size block size in bytes
+ */
+void codec_encoder_init(codec_encoder_t* enc, uint8_t* buf, size_t size)
+{
+    memset(buf, 0, size);
+    *enc = (codec_encoder_t){ .buf = buf, .size_bits = (uint32_t)size * 8 };
+}
+
+/**
+ * @brief append one sample to the block
+ *
+ * @details The sample is sized first, so a sample that does not fit
+ * leaves the block untouched
+ *
+ * @return false if the block is full
+ */
+bool codec_encode(codec_encoder_t* enc, const sensor_sample_t* sample)
+{
+    if (enc->count == 0)
+    {
+        // first sample raw: the block needs no context from before it
+        if (enc->size_bits - enc->bit_pos < 64)
+        {
+            return false;
+        }
+        put_bits(enc, sample->timestamp_ms, 32);
+        put_bits(enc, (uint16_t)sample->temp, 16);
+        put_bits(enc, (uint16_t)sample->humidity, 16);
+        enc->prev_ts = sample->timestamp_ms;
+        enc->prev_delta = 0;
+        enc->prev_temp = (int16_t)sample->temp;
+        enc->prev_humidity = (int16_t)sample->humidity;
+        enc->count = 1;
+        return true;
+    }
+
+    // wrapping arithmetic keeps every field exact, whatever the jump
+    int32_t delta = (int32_t)(sample->timestamp_ms - enc->prev_ts);
+    uint32_t dod = zigzag((int32_t)((uint32_t)delta - (uint32_t)enc->prev_delta));
+    uint32_t dtemp = zigzag((int32_t)((uint32_t)sample->temp - (uint32_t)enc->prev_temp));
+    uint32_t dhum = zigzag((int32_t)((uint32_t)sample->humidity - (uint32_t)enc->prev_humidity));
+
+    if (code_bits(dod) + code_bits(dtemp) + code_bits(dhum) > enc->size_bits - enc->bit_pos ||
+        enc->count == UINT16_MAX)
+    {
+        return false;
+    }
+
+    put_code(enc, dod);
+    put_code(enc, dtemp);
+    put_code(enc, dhum);
+
+    enc->prev_ts = sample->timestamp_ms;
+    enc->prev_delta = delta;
+    enc->prev_temp = sample->temp;
+    enc->prev_humidity = sample->humidity;
+    enc->count++;
+    return true;
+}
+
+/**
+ * @brief bytes of the block used so far
+ */
+size_t codec_encoded_bytes(const codec_encoder_t* enc)
+{
+    return (enc->bit_pos + 7) / 8;
+}
+
+/**
+ * @brief start decoding a block from its first sample
+ */
+void codec_decoder_init(codec_decoder_t* dec, const uint8_t* buf, size_t size)
+{
+    *dec = (codec_decoder_t){ .buf = buf, .size_bits = (uint32_t)size * 8 };
+}
+
+/**
+ * @brief read n bits, most significant first
+ */
+static uint32_t get_bits(codec_decoder_t* dec, uint8_t n)
+{
+    uint32_t value = 0;
+
+    while (n > 0)
+    {
+        n--;
+        uint32_t bit = (dec->buf[dec->bit_pos >> 3] >> (7 - (dec->bit_pos & 7))) & 1;
+        value = (value << 1) | bit;
+        dec->bit_pos++;
+    }
+    return value;
+}
+
+/**
+ * @brief read one prefix-coded value
+ *
+ * @return false if the block ends inside the code
+ */
+static bool get_code(codec_decoder_t* dec, uint32_t* zz)
+{
+    static const uint8_t payload_bits[] = { 4, 7, 12, 32 };
+    uint8_t ones = 0;
+
+    // count leading ones, up to four
+    while (ones < 4)
+    {
+        if (dec->bit_pos >= dec->size_bits)
+        {
+            return false;
+        }
+        if (get_bits(dec, 1) == 0)
+        {
+            break;
+        }
+        ones++;
+    }
+
+    if (ones == 0)
+    {
+        *zz = 0;
+        return true;
+    }
+
+    uint8_t n = payload_bits[ones - 1];
+    if (dec->size_bits - dec->bit_pos < n)
+    {
+        return false;
+    }
+    *zz = get_bits(dec, n);
+    return true;
+}
+
+/**
+ * @brief decode the next sample
+ *
+ * @details The block does not record its own length; the caller stops
+ * after the number of samples it knows the block holds
+ *
+ * @return false if the block ends before a whole sample
+ */
+bool codec_decode(codec_decoder_t* dec, sensor_sample_t* out)
+{
+    if (dec->count == 0)
+    {
+        if (dec->size_bits - dec->bit_pos < 64)
+        {
+            return false;
+        }
+        dec->prev_ts = get_bits(dec, 32);
+        dec->prev_temp = (int16_t)get_bits(dec, 16);
+        dec->prev_humidity = (int16_t)get_bits(dec, 16);
+        dec->prev_delta = 0;
+    }
+    else
+    {
+        uint32_t dod;
+        uint32_t dtemp;
+        uint32_t dhum;
+
+        if (!get_code(dec, &dod) || !get_code(dec, &dtemp) || !get_code(dec, &dhum))
+        {
+            return false;
+        }
+
+        dec->prev_delta = (int32_t)((uint32_t)dec->prev_delta + (uint32_t)unzigzag(dod));
+        dec->prev_ts += (uint32_t)dec->prev_delta;
+        dec->prev_temp = (int32_t)((uint32_t)dec->prev_temp + (uint32_t)unzigzag(dtemp));
+        dec->prev_humidity = (int32_t)((uint32_t)dec->prev_humidity + (uint32_t)unzigzag(dhum));
+    }
+
+    dec->count++;
+    out->timestamp_ms = dec->prev_ts;
+    out->temp = dec->prev_temp;
+    out->humidity = dec->prev_humidity;
+    return true;
+}
@@ -0,0 +1,61 @@
+/**
+ * @file sample_codec.h
+ * @brief Streaming bit-packed codec for the sample time series
+ *
+ * A block starts with one raw sample (32-bit timestamp, 16-bit temp and
+ * humidity). Each later sample stores the timestamp as a delta-of-delta
+ * and temperature and humidity as deltas, all zig-zag mapped and written
+ * with a prefix code:
+ *
+ *   0                 value 0
+ *   10   + 4 bits     zig-zag < 16
+ *   110  + 7 bits     zig-zag < 128
+ *   1110 + 12 bits    zig-zag < 4096
+ *   1111 + 32 bits    anything else
+ *
+ * At 1 Hz a steady timestamp costs 1 bit and a slowly drifting channel
+ * 1 to 6 bits, so a sample usually takes 1 to 2 bytes instead of 8.
+ *
+ * Blocks are self-contained, so any block (a flash page, a history block)
+ * can be decoded without the ones before it. Encoder and decoder state is
+ * a handful of words, updated in O(1) per sample.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+#define CODEC_MAX_SAMPLE_BITS 108   // worst case: three 36-bit fields
+
+typedef struct
+{
+    uint8_t* buf;
+    uint32_t size_bits;
+    uint32_t bit_pos;
+    uint16_t count;         // samples in the block
+    uint32_t prev_ts;
+    int32_t prev_delta;     // previous timestamp delta
+    int32_t prev_temp;
+    int32_t prev_humidity;
+} codec_encoder_t;
+
+typedef struct
+{
+    const uint8_t* buf;
+    uint32_t size_bits;
+    uint32_t bit_pos;
+    uint16_t count;         // samples decoded so far
+    uint32_t prev_ts;
+    int32_t prev_delta;
+    int32_t prev_temp;
+    int32_t prev_humidity;
+} codec_decoder_t;
+
+void codec_encoder_init(codec_encoder_t* enc, uint8_t* buf, size_t size);
+bool codec_encode(codec_encoder_t* enc, const sensor_sample_t* sample);
+size_t codec_encoded_bytes(const codec_encoder_t* enc);
+void codec_decoder_init(codec_decoder_t* dec, const uint8_t* buf, size_t size);
+bool codec_decode(codec_decoder_t* dec, sensor_sample_t* out);
@@ -0,0 +1,261 @@
+/**
+ * @file sample_filter.c
+ * @brief Sliding-median filter and Hampel outlier gate for DHT20 readings
+ *
+ * Runs wherever sensor_task_poll() runs (core1 in multicore builds).
+ * Settings are written by commands on core0 and picked up on the next
+ * reading.
+ */
+
+#include <string.h>
+#include "sample_filter.h"
+
+// 1.4826 * MAD estimates the standard deviation of normal noise
+#define MAD_SCALE 14826
+#define MAD_SCALE_DIV 10000
+
+typedef enum
+{
+    CHANNEL_TEMP,
+    CHANNEL_HUMIDITY,
+    CHANNEL_COUNT
+} channel_index_t;
+
+// Last `window` raw readings of one channel
+typedef struct
+{
+    int32_t raw[FILTER_MAX_WINDOW];     // arrival order, oldest at head
+    int32_t sorted[FILTER_MAX_WINDOW];  // same values, ascending
+    uint8_t head;
+    uint8_t count;
+} channel_t;
+
+static channel_t channels[CHANNEL_COUNT];
+static uint8_t window = FILTER_DEFAULT_WINDOW;
+static volatile uint8_t requested_window = FILTER_DEFAULT_WINDOW;
+static volatile uint16_t k_centi = FILTER_DEFAULT_K;
+static sample_filter_stats_t stats;
+
+/**
+ * @brief index of the first sorted entry not less than value
+ */
+static uint8_t lower_bound(const int32_t* sorted, uint8_t count, int32_t value)
+{
+    uint8_t lo = 0;
+    uint8_t hi = count;
+
+    while (lo < hi)
+    {
+        uint8_t mid = (uint8_t)((lo + hi) / 2);
+        if (sorted[mid] < value)
+        {
+            lo = (uint8_t)(mid + 1);
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief add a reading, evicting the oldest once the window is full
+ *
+ * @details The evicted value is found by binary search and the new one
+ * slides from its slot to its sorted place, so the cost is O(log N) plus
+ * the distance moved
+ */
+static void channel_insert(channel_t* ch, int32_t value)
+{
+    if (ch->count < window)
+    {
+        uint8_t pos = lower_bound(ch->sorted, ch->count, value);
+        memmove(&ch->sorted[pos + 1], &ch->sorted[pos], (ch->count - pos) * sizeof(int32_t));
+        ch->sorted[pos] = value;
+        ch->raw[(ch->head + ch->count) % window] = value;
+        ch->count++;
+        return;
+    }
+
+    int32_t oldest = ch->raw[ch->head];
+    ch->raw[ch->head] = value;
+    ch->head = (uint8_t)((ch->head + 1) % window);
+
+    uint8_t i = lower_bound(ch->sorted, ch->count, oldest);
+    while (i > 0 && ch->sorted[i - 1] > value)
+    {
+        ch->sorted[i] = ch->sorted[i - 1];
+        i--;
+    }
+    while (i + 1 < ch->count && ch->sorted[i + 1] < value)
+    {
+        ch->sorted[i] = ch->sorted[i + 1];
+        i++;
+    }
+    ch->sorted[i] = value;
+}
+
+/**
+ * @brief median of the window (mean of the middle pair for an even count)
+ */
+static int32_t channel_median(const channel_t* ch)
+{
+    uint8_t mid = ch->count / 2;
+
+    if (ch->count % 2 == 1)
+    {
+        return ch->sorted[mid];
+    }
+    return ch->sorted[mid - 1] + (ch->sorted[mid] - ch->sorted[mid - 1]) / 2;
+}
+
+/**
+ * @brief median absolute deviation from the window median
+ *
+ * @details Deviations grow outwards from the middle of the sorted window
+ * on both sides, so merging the two sides finds the median deviation in
+ * N/2 steps without sorting
+ */
+static int32_t channel_mad(const channel_t* ch, int32_t median)
+{
+    int left = (ch->count - 1) / 2;
+    int right = left + 1;
+    int32_t dev = 0;
+
+    for (int taken = 0; taken <= ch->count / 2; taken++)
+    {
+        int32_t dl = (left >= 0) ? median - ch->sorted[left] : INT32_MAX;
+        int32_t dr = (right < ch->count) ? ch->sorted[right] - median : INT32_MAX;
+        if (dl < 0)
+        {
+            dl = -dl;
+        }
+        if (dl <= dr)
+        {
+            dev = dl;
+            left--;
+        }
+        else
+        {
+            dev = dr;
+            right++;
+        }
+    }
+    return dev;
+}
+
+/**
+ * @brief Hampel test of a reading against the readings before it
+ *
+ * @param floor deviation that always passes, so a flat window (MAD 0)
+ * does not reject sensor noise
+ *
+ * @return true if the reading passes
+ */
+static bool channel_gate(const channel_t* ch, int32_t value, int32_t floor, uint16_t k)
+{
+    if (k == 0 || ch->count < FILTER_MIN_GATE_SAMPLES)
+    {
+        return true;
+    }
+
+    int32_t median = channel_median(ch);
+    int32_t dev = (value > median) ? value - median : median - value;
+    if (dev <= floor)
+    {
+        return true;
+    }
+
+    int64_t limit = (int64_t)channel_mad(ch, median) * k * MAD_SCALE / (MAD_SCALE_DIV * 100);
+    return dev <= limit;
+}
+
+/**
+ * @brief gate a new reading and replace its values with the window median
+ *
+ * @param sample reading in centi-units; updated in place when accepted
+ *
+ * @return false if the reading is an outlier and should be dropped
+ */
+bool sample_filter_apply(sensor_sample_t* sample)
+{
+    if (window != requested_window)
+    {
+        // restart from an empty window at the new size
+        window = requested_window;
+        memset(channels, 0, sizeof(channels));
+    }
+
+    uint16_t k = k_centi;
+    bool temp_ok = channel_gate(&channels[CHANNEL_TEMP], sample->temp, FILTER_TEMP_FLOOR, k);
+    bool humidity_ok = channel_gate(&channels[CHANNEL_HUMIDITY], sample->humidity, FILTER_HUMIDITY_FLOOR, k);
+
+    channel_insert(&channels[CHANNEL_TEMP], sample->temp);
+    channel_insert(&channels[CHANNEL_HUMIDITY], sample->humidity);
+
+    if (!temp_ok)
+    {
+        stats.rejected_temp++;
+    }
+    if (!humidity_ok)
+    {
+        stats.rejected_humidity++;
+    }
+    if (!temp_ok || !humidity_ok)
+    {
+        return false;
+    }
+
+    sample->temp = channel_median(&channels[CHANNEL_TEMP]);
+    sample->humidity = channel_median(&channels[CHANNEL_HUMIDITY]);
+    stats.accepted++;
+    return true;
+}
+
+/**
+ * @brief set the median window; 1 passes readings through unfiltered
+ *
+ * @param n readings per window, 1 to FILTER_MAX_WINDOW
+ */
+void sample_filter_set_window(uint8_t n)
+{
+    if (n == 0 || n > FILTER_MAX_WINDOW)
+    {
+        return;
+    }
+    requested_window = n;
+}
+
+/**
+ * @brief set the Hampel threshold
+ *
+ * @param k threshold in centi-MADs; 0 turns the gate off
+ */
+void sample_filter_set_k(uint16_t k)
+{
+    k_centi = k;
+}
+
+uint8_t sample_filter_get_window(void)
+{
+    return requested_window;
+}
+
+uint16_t sample_filter_get_k(void)
+{
+    return k_centi;
+}
+
+/**
+ * @brief accepted and rejected reading counters
+ */
+const sample_filter_stats_t* sample_filter_get_stats(void)
+{
+    return &stats;
+}
+
+void sample_filter_reset_stats(void)
+{
+    memset(&stats, 0, sizeof(stats));
+}
@@ -0,0 +1,43 @@
+/**
+ * @file sample_filter.h
+ * @brief Sliding-median filter and Hampel outlier gate for DHT20 readings
+ *
+ * Runs in the acquisition path, before a sample is queued. Per channel it
+ * keeps the last N raw readings both in arrival order and sorted, so the
+ * median is read directly and each new reading costs a binary search plus
+ * a shift of at most N entries.
+ *
+ * A reading is dropped when it is further from the median of the previous
+ * readings than k scaled MADs (median absolute deviation), and never for a
+ * deviation within the channel's floor. Dropped readings still enter the
+ * window, so a real step change passes once it holds the majority.
+ * Accepted samples carry the window median.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+#define FILTER_MAX_WINDOW 15
+#define FILTER_DEFAULT_WINDOW 5
+#define FILTER_DEFAULT_K 300       // centi-MADs (3.00)
+#define FILTER_MIN_GATE_SAMPLES 3  // readings needed before the gate acts
+#define FILTER_TEMP_FLOOR 50       // centi-degrees; smaller deviations always pass
+#define FILTER_HUMIDITY_FLOOR 200  // centi-percent
+
+typedef struct
+{
+    uint32_t accepted;          // samples passed on
+    uint32_t rejected_temp;     // samples dropped for a temperature outlier
+    uint32_t rejected_humidity; // samples dropped for a humidity outlier
+} sample_filter_stats_t;
+
+bool sample_filter_apply(sensor_sample_t* sample);
+void sample_filter_set_window(uint8_t window);
+void sample_filter_set_k(uint16_t k_centi);
+uint8_t sample_filter_get_window(void);
+uint16_t sample_filter_get_k(void);
+const sample_filter_stats_t* sample_filter_get_stats(void);
+void sample_filter_reset_stats(void);
@@ -0,0 +1,191 @@
+/**
+ * @file sample_history.c
+ * @brief RAM history of recent samples, stored as compressed blocks
+ */
+
+#include "pico/time.h"
+#include "sample_codec.h"
+#include "sample_history.h"
+
+typedef struct
+{
+    uint32_t first_seq;     // sequence number of the block's first sample
+    uint16_t count;         // samples in the block
+    uint8_t data[HISTORY_BLOCK_SIZE];
+} history_block_t;
+
+static history_block_t blocks[HISTORY_BLOCKS];
+static uint32_t head_block = 0;   // free-running index of the block being filled
+static uint32_t head = 0;         // sequence number of the next sample
+static codec_encoder_t encoder;   // state for blocks[head_block]
+static history_stats_t stats;
+
+// decoder kept between history_get() calls for sequential reads
+static struct
+{
+    bool valid;
+    uint32_t block;       // free-running block index
+    uint32_t next_seq;    // sample the decoder returns next
+    codec_decoder_t decoder;
+} cursor;
+
+/**
+ * @brief block for a free-running block index
+ */
+static history_block_t* block_at(uint32_t index)
+{
+    return &blocks[index % HISTORY_BLOCKS];
+}
+
+/**
+ * @brief free-running index of the oldest block still held
+ */
+static uint32_t oldest_block(void)
+{
+    return (head_block >= HISTORY_BLOCKS) ? head_block - (HISTORY_BLOCKS - 1) : 0;
+}
+
+/**
+ * @brief start encoding into the block after the head, dropping the oldest
+ */
+static void start_block(uint32_t index)
+{
+    history_block_t* block = block_at(index);
+
+    head_block = index;
+    block->first_seq = head;
+    block->count = 0;
+    codec_encoder_init(&encoder, block->data, sizeof(block->data));
+    stats.blocks++;
+}
+
+/**
+ * @brief append a sample, starting a new block when the current one is full
+ *
+ * @param sample sample in centi-units
+ */
+void history_push(const sensor_sample_t* sample)
+{
+    uint32_t start = time_us_32();
+
+    if (stats.blocks == 0)
+    {
+        start_block(0);
+    }
+
+    if (!codec_encode(&encoder, sample))
+    {
+        start_block(head_block + 1);
+        codec_encode(&encoder, sample);
+    }
+
+    block_at(head_block)->count = encoder.count;
+    head++;
+
+    stats.samples++;
+    stats.encode_total_us += time_us_32() - start;
+}
+
+/**
+ * @brief sequence number the next sample will get (total samples pushed)
+ */
+uint32_t history_head(void)
+{
+    return head;
+}
+
+/**
+ * @brief number of samples currently held
+ */
+size_t history_count(void)
+{
+    if (stats.blocks == 0)
+    {
+        return 0;
+    }
+    return head - block_at(oldest_block())->first_seq;
+}
+
+/**
+ * @brief bytes of encoded data currently held
+ */
+size_t history_bytes_used(void)
+{
+    if (stats.blocks == 0)
+    {
+        return 0;
+    }
+    return (head_block - oldest_block()) * HISTORY_BLOCK_SIZE + codec_encoded_bytes(&encoder);
+}
+
+/**
+ * @brief find the block holding a sequence number (binary search)
+ */
+static uint32_t find_block(uint32_t seq)
+{
+    uint32_t lo = oldest_block();
+    uint32_t hi = head_block;
+
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo + 1) / 2;
+        if ((int32_t)(block_at(mid)->first_seq - seq) <= 0)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+    return lo;
+}
+
+/**
+ * @brief read one sample by sequence number
+ *
+ * @details Reading seq right after seq - 1 continues the previous decode;
+ * any other seq decodes its block from the start
+ *
+ * @param seq sequence number, see history_head()
+ * @param out location to store the sample in centi-units
+ *
+ * @return false if seq is not written yet or has been overwritten
+ */
+bool history_get(uint32_t seq, sensor_sample_t* out)
+{
+    if (head - seq - 1 >= history_count())
+    {
+        return false;
+    }
+
+    if (!cursor.valid || cursor.next_seq != seq || cursor.block < oldest_block() ||
+        seq - block_at(cursor.block)->first_seq >= block_at(cursor.block)->count)
+    {
+        // random access, or the cursor ran off its block
+        cursor.block = find_block(seq);
+        history_block_t* block = block_at(cursor.block);
+        codec_decoder_init(&cursor.decoder, block->data, sizeof(block->data));
+        cursor.next_seq = block->first_seq;
+        cursor.valid = true;
+    }
+
+    while (cursor.next_seq != seq + 1)
+    {
+        if (!codec_decode(&cursor.decoder, out))
+        {
+            cursor.valid = false;
+            return false;
+        }
+        cursor.next_seq++;
+    }
+    return true;
+}
+
+/**
+ * @brief encoding counters
+ */
+const history_stats_t* history_get_stats(void)
+{
+    return &stats;
+}
@@ -0,0 +1,42 @@
+/**
+ * @file sample_history.h
+ * @brief RAM history of recent samples, stored as compressed blocks
+ *
+ * The history is a ring of fixed-size sample_codec blocks. New samples are
+ * encoded into the newest block. When it is full the next block is started,
+ * overwriting the oldest, so memory use is fixed while the number of
+ * samples held depends on how well the data compresses (around 150 per
+ * block for a real sensor at 1 Hz, far more for steady mock values).
+ *
+ * Samples are addressed by a free-running sequence number. history_get()
+ * refuses entries that have been overwritten, so a reader walking the
+ * history can tell when the writer has lapped it. Sequential reads reuse
+ * the decoder state and cost O(1) per sample.
+ *
+ * Written and read only from scheduler context on core0.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+#define HISTORY_BLOCK_SIZE 248   // bytes of encoded samples per block
+#define HISTORY_BLOCKS 256       // ~64 KB in total
+
+// Encoding counters
+typedef struct
+{
+    uint32_t samples;           // samples encoded since boot
+    uint32_t blocks;            // blocks started since boot
+    uint64_t encode_total_us;   // time spent encoding
+} history_stats_t;
+
+void history_push(const sensor_sample_t* sample);
+uint32_t history_head(void);
+size_t history_count(void);
+size_t history_bytes_used(void);
+bool history_get(uint32_t seq, sensor_sample_t* out);
+const history_stats_t* history_get_stats(void);
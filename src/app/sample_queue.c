@@ -0,0 +1,102 @@
+/**
+ * @file sample_queue.c
+ * @brief Lock-free single-producer/single-consumer queue of sensor samples
+ */
+
+#include "hardware/sync.h"
+#include "sample_queue.h"
+
+#define SAMPLE_QUEUE_MASK (SAMPLE_QUEUE_SIZE - 1)
+
+_Static_assert((SAMPLE_QUEUE_SIZE & SAMPLE_QUEUE_MASK) == 0,
+               "SAMPLE_QUEUE_SIZE must be a power of two");
+
+static sensor_sample_t queue[SAMPLE_QUEUE_SIZE];
+
+// Free-running indices: head is only written by the producer, tail only
+// by the consumer. head - tail is the fill level even across wraparound.
+static volatile uint32_t head = 0;
+static volatile uint32_t tail = 0;
+
+// Producer-owned counters
+static volatile uint32_t pushed = 0;
+static volatile uint32_t overflows = 0;
+
+/**
+ * @brief Add a sample to the queue (producer side)
+ *
+ * A full queue drops the new sample and counts the overflow rather than
+ * blocking the acquisition context
+ *
+ * @param sample the sample to copy into the queue
+ *
+ * @return true if queued, false if dropped
+ */
+bool sample_queue_push(const sensor_sample_t* sample)
+{
+    uint32_t h = head;
+
+    if (h - tail >= SAMPLE_QUEUE_SIZE)
+    {
+        overflows++;
+        return false;
+    }
+
+    queue[h & SAMPLE_QUEUE_MASK] = *sample;
+
+    // slot contents must be visible before the new head
+    __mem_fence_release();
+    head = h + 1;
+    pushed++;
+
+    return true;
+}
+
+/**
+ * @brief Remove up to max samples in arrival order (consumer side)
+ *
+ * @param out array to copy the samples into
+ * @param max capacity of out
+ *
+ * @return number of samples copied
+ */
+size_t sample_queue_drain(sensor_sample_t* out, size_t max)
+{
+    uint32_t t = tail;
+    uint32_t available = head - t;
+    size_t count = 0;
+
+    // read head before the slots it publishes
+    __mem_fence_acquire();
+
+    while (count < max && count < available)
+    {
+        out[count++] = queue[t & SAMPLE_QUEUE_MASK];
+        t++;
+    }
+
+    // slots must be copied out before the producer may reuse them
+    __mem_fence_release();
+    tail = t;
+
+    return count;
+}
+
+/**
+ * @brief Number of samples waiting to be drained
+ */
+size_t sample_queue_count(void)
+{
+    return head - tail;
+}
+
+/**
+ * @brief Snapshot the queue counters
+ *
+ * @param stats location to store the counters
+ */
+void sample_queue_get_stats(sample_queue_stats_t* stats)
+{
+    stats->pushed = pushed;
+    stats->overflows = overflows;
+}
@@ -0,0 +1,36 @@
+/**
+ * @file sample_queue.h
+ * @brief Lock-free single-producer/single-consumer queue of sensor samples
+ *
+ * The acquisition context pushes, the main loop drains. Neither side
+ * takes a lock: each index is written by exactly one side and published
+ * with a memory fence, so it is safe between an IRQ and thread code or
+ * between the two RP2040 cores.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define SAMPLE_QUEUE_SIZE 16  // must be a power of two
+
+// One timestamped measurement in fixed-point units
+typedef struct
+{
+    uint32_t timestamp_ms;  // ms since boot when the sample was collected
+    int32_t temp;           // centi-degrees celsius
+    int32_t humidity;       // centi-percent
+} sensor_sample_t;
+
+typedef struct
+{
+    uint32_t pushed;     // samples accepted by the queue
+    uint32_t overflows;  // samples dropped because the queue was full
+} sample_queue_stats_t;
+
+bool sample_queue_push(const sensor_sample_t* sample);
+size_t sample_queue_drain(sensor_sample_t* out, size_t max);
+size_t sample_queue_count(void);
+void sample_queue_get_stats(sample_queue_stats_t* stats);
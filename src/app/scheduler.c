@@ -0,0 +1,229 @@
+/**
+ * @file scheduler.c
+ * @brief Cooperative run-to-completion task scheduler with timing stats
+ */
+
+#include <stdio.h>
+#include <stddef.h>
+#include "pico/time.h"
+#include "scheduler.h"
+
+static sched_task_t tasks[SCHED_MAX_TASKS];
+static uint8_t task_count = 0;
+static volatile alarm_id_t timer_alarm = 0;  // 0 when no alarm is pending
+static uint32_t timer_target = 0;            // release the alarm fires for
+
+/**
+ * @brief add a task to the table
+ *
+ * @return the new task, or NULL if the table is full
+ */
+static sched_task_t* add_task(const char* name, task_fn_t fn, uint32_t period_us,
+                              uint32_t deadline_us, event_type_t event)
+{
+    if (task_count >= SCHED_MAX_TASKS)
+    {
+        printf("\nERROR: Task table full\n");
+        return NULL;
+    }
+
+    sched_task_t* task = &tasks[task_count++];
+    task->name = name;
+    task->fn = fn;
+    task->period_us = period_us;
+    task->deadline_us = deadline_us;
+    task->event = event;
+    task->release_us = time_us_32() + period_us;
+    task->again = false;
+    task->stats.min_lateness_us = UINT32_MAX;
+
+    return task;
+}
+
+/**
+ * @brief register a task released every period_us
+ *
+ * Tasks run in registration order within a pass, so register the most
+ * latency-sensitive tasks first
+ *
+ * @param name task name for the 'tasks' command
+ * @param fn task body
+ * @param period_us release period
+ * @param deadline_us release-to-completion budget
+ *
+ * @return true if registered
+ */
+bool sched_add_periodic(const char* name, task_fn_t fn, uint32_t period_us, uint32_t deadline_us)
+{
+    return add_task(name, fn, period_us, deadline_us, EVENT_COUNT) != NULL;
+}
+
+/**
+ * @brief register a task released whenever an event is posted
+ *
+ * @param name task name for the 'tasks' command
+ * @param fn task body
+ * @param event releasing event
+ * @param deadline_us post-to-completion budget
+ *
+ * @return true if registered
+ */
+bool sched_add_event(const char* name, task_fn_t fn, event_type_t event, uint32_t deadline_us)
+{
+    return add_task(name, fn, 0, deadline_us, event) != NULL;
+}
+
+/**
+ * @brief check whether a task is released, and from when
+ *
+ * @param task task to check
+ * @param now current time_us_32()
+ * @param release location to store the release time
+ *
+ * @return true if the task should run now
+ */
+static bool task_released(sched_task_t* task, uint32_t now, uint32_t* release)
+{
+    if (task->again)
+    {
+        task->again = false;
+        *release = now;
+        return true;
+    }
+
+    if (task->period_us == 0)
+    {
+        return event_take(task->event, release);
+    }
+
+    if ((int32_t)(now - task->release_us) >= 0)
+    {
+        *release = task->release_us;
+        // next release on the period grid, skipping any that were missed
+        do
+        {
+            task->release_us += task->period_us;
+        } while ((int32_t)(now - task->release_us) >= 0);
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief run a released task and update its statistics
+ */
+static void run_task(sched_task_t* task, uint32_t release)
+{
+    task_stats_t* stats = &task->stats;
+    uint32_t start = time_us_32();
+
+    task->again = task->fn();
+
+    uint32_t end = time_us_32();
+    uint32_t run_us = end - start;
+    uint32_t lateness_us = start - release;
+
+    stats->runs++;
+    stats->total_run_us += run_us;
+    if (run_us > stats->max_run_us)
+        stats->max_run_us = run_us;
+    if (lateness_us < stats->min_lateness_us)
+        stats->min_lateness_us = lateness_us;
+    if (lateness_us > stats->max_lateness_us)
+        stats->max_lateness_us = lateness_us;
+    if (end - release > task->deadline_us)
+        stats->deadline_misses++;
+}
+
+static int64_t timer_callback(alarm_id_t id, void* user_data)
+{
+    timer_alarm = 0;
+    event_post(EVENT_TIMER);
+    return 0;
+}
+
+/**
+ * @brief arm one alarm for the earliest periodic release
+ *
+ * The alarm is left alone if it already targets that release
+ */
+static void arm_timer(uint32_t now)
+{
+    bool found = false;
+    uint32_t next = 0;
+
+    for (uint8_t i = 0; i < task_count; i++)
+    {
+        if (tasks[i].period_us == 0)
+            continue;
+
+        if (!found || (int32_t)(tasks[i].release_us - next) < 0)
+        {
+            next = tasks[i].release_us;
+            found = true;
+        }
+    }
+
+    if (!found || (timer_alarm > 0 && next == timer_target))
+        return;
+
+    if (timer_alarm > 0)
+        cancel_alarm(timer_alarm);
+
+    int32_t until = (int32_t)(next - now);
+    timer_alarm = add_alarm_in_us(until > 0 ? (uint32_t)until : 0, timer_callback, NULL, true);
+    timer_target = next;
+}
+
+/**
+ * @brief run the scheduler forever
+ *
+ * Each pass runs every released task once, in registration order, then
+ * sleeps in event_wait() until the next event or periodic release
+ */
+void sched_run(void)
+{
+    while (true)
+    {
+        bool yielded = false;
+
+        event_take(EVENT_TIMER, NULL);
+
+        for (uint8_t i = 0; i < task_count; i++)
+        {
+            uint32_t release;
+            if (task_released(&tasks[i], time_us_32(), &release))
+            {
+                run_task(&tasks[i], release);
+                yielded |= tasks[i].again;
+            }
+        }
+
+        if (!yielded)
+        {
+            arm_timer(time_us_32());
+            event_wait();
+        }
+    }
+}
+
+/**
+ * @brief number of registered tasks
+ */
+uint8_t sched_task_count(void)
+{
+    return task_count;
+}
+
+/**
+ * @brief get a registered task with its statistics
+ *
+ * @param index task index, 0 to sched_task_count() - 1
+ *
+ * @return the task, or NULL if out of range
+ */
+const sched_task_t* sched_get_task(uint8_t index)
+{
+    return (index < task_count) ? &tasks[index] : NULL;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file scheduler.h
+ * @brief Cooperative run-to-completion task scheduler with timing stats
+ *
+ * Tasks are stackless: each run is a plain function call that must
+ * return quickly. A task is released either periodically or by an
+ * event from events.h. A task that returns true yields with work left
+ * and is released again on the next pass, protothread style.
+ *
+ * Per task the scheduler records run time (average and worst case),
+ * release-to-start lateness (jitter) and deadline misses, where the
+ * deadline is measured from release to completion.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "events.h"
+
+#define SCHED_MAX_TASKS 12
+
+// Task body: return true to be run again as soon as possible
+typedef bool (*task_fn_t)(void);
+
+typedef struct
+{
+    uint32_t runs;
+    uint32_t max_run_us;
+    uint64_t total_run_us;
+    uint32_t min_lateness_us;    // earliest start after release
+    uint32_t max_lateness_us;    // latest start after release
+    uint32_t deadline_misses;
+} task_stats_t;
+
+typedef struct
+{
+    const char* name;
+    task_fn_t fn;
+    uint32_t period_us;          // 0 for event-driven tasks
+    uint32_t deadline_us;        // release-to-completion budget
+    event_type_t event;          // releasing event (EVENT_COUNT if periodic)
+
+    // scheduler state
+    uint32_t release_us;         // time_us_32() of the pending release
+    bool again;                  // task yielded with work left
+    task_stats_t stats;
+} sched_task_t;
+
+bool sched_add_periodic(const char* name, task_fn_t fn, uint32_t period_us, uint32_t deadline_us);
+bool sched_add_event(const char* name, task_fn_t fn, event_type_t event, uint32_t deadline_us);
+void sched_run(void);
+uint8_t sched_task_count(void);
+const sched_task_t* sched_get_task(uint8_t index);
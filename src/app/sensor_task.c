@@ -1,40 +1,110 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "../drivers/dht20.h"
+#include "hardware/sync.h"
 #include "pico/time.h"
+#if SENSOR_MULTICORE
+#include "pico/multicore.h"
+#include "pico/flash.h"
+#endif
+#include "events.h"
+#include "fixed_point.h"
+#include "sample_filter.h"
 #include "sensor_task.h"
 
-static bool sensor_data_ready = false;
+// Measurement state machine, stepped from sensor_task_poll()
+typedef enum
+{
+    SENSOR_IDLE,       // waiting for the next timer tick
+    SENSOR_MEASURING,  // triggered, waiting for the busy bit to clear
+    SENSOR_BACKOFF     // last attempt failed, waiting to retry
+} sensor_state_t;
+
+// Retry policy for failed measurements
+#define SENSOR_MAX_RETRIES 3          // retries per sample before giving up
+#define SENSOR_RETRY_BACKOFF_MS 10    // first backoff, doubled per retry
+
+static sensor_state_t sensor_state = SENSOR_IDLE;
+static volatile bool measure_due = false;
+static volatile bool poll_due = false;
 static struct repeating_timer sensor_timer;
+static uint8_t sensor_attempt = 0;
+static uint8_t sensor_polls = 0;
+static sensor_task_stats_t sensor_stats;
 
 // variables for sensor data return
+// (mock settings are written by commands on core0 and read by acquisition)
 static temp_unit_t current_temp_unit = TEMP_CELSIUS;
-static bool mock_sensor = false;
-static float mock_temp = 20.0;
-static float mock_humid = 50.0;
+static volatile bool mock_sensor = false;
+static volatile int32_t mock_temp = 2000;     // centi-degrees celsius
+static volatile int32_t mock_humid = 5000;    // centi-percent
 
 /**
- * @brief callback function to read from the sensor
+ * @brief wake whichever context runs sensor_task_poll()
+ */
+static void wake_acquisition(void)
+{
+#if SENSOR_MULTICORE
+    __sev(); // core1 waits in __wfe()
+#else
+    event_post(EVENT_SENSOR_STEP);
+#endif
+}
+
+/**
+ * @brief callback function to start a sensor measurement
+ *
+ * @details This callback function sets the measure_due flag
+ * to inform the main loop that it should trigger a new measurement.
+ * No I2C is performed in this function due to i2c conflicts with the LCD
  *
- * @details This callback function sets the sensor_data_ready flag 
- * to inform the main loop that it should read temperature and humidity values.
- * A sensor read is not performed in this function due to i2c conflicts
- * j
  * @param t the repeating timer for the callback
  */
 static bool sensor_task_callback(struct repeating_timer* t)
 {
-    sensor_data_ready = true;
+    measure_due = true;
+    wake_acquisition();
     return true;
 }
 
+/**
+ * @brief one-shot alarm callback to check on a running measurement
+ *
+ * @return 0 so the alarm is not rescheduled
+ */
+static int64_t sensor_poll_callback(alarm_id_t id, void* user_data)
+{
+    poll_due = true;
+    wake_acquisition();
+    return 0;
+}
+
 /**
 *@brief initiate a repeating timer for a sensor read task
 *
 */
 void init_sensor_task(void)
 {
-    add_repeating_timer_ms(1000, sensor_task_callback, NULL, &sensor_timer);
+    add_repeating_timer_ms(1000 / SENSOR_DEFAULT_RATE_HZ, sensor_task_callback, NULL, &sensor_timer);
+}
+
+/**
+* @brief change how often a measurement is started
+*
+* @details Ticks that arrive while a measurement is still running
+* coalesce, so a rate the sensor cannot keep up with just skips ticks
+*
+* @param hz samples per second, 1 to SENSOR_MAX_RATE_HZ
+*/
+void set_sample_rate_hz(uint8_t hz)
+{
+    if (hz == 0 || hz > SENSOR_MAX_RATE_HZ)
+    {
+        return;
+    }
+
+    cancel_repeating_timer(&sensor_timer);
+    add_repeating_timer_ms(1000 / hz, sensor_task_callback, NULL, &sensor_timer);
 }
 
 /**
@@ -47,26 +117,42 @@ void set_temp_unit(uint8_t unit)
     current_temp_unit = (temp_unit_t)unit;
 }
 
+/**
+* @brief get the selected temperature unit
+*/
+temp_unit_t get_temp_unit(void)
+{
+    return current_temp_unit;
+}
+
+/**
+* @brief check whether mock mode is enabled
+*/
+bool get_mock_sensor(void)
+{
+    return mock_sensor;
+}
+
 /**
 * @brief convert a temperature from celcius to farenheit if needed
 *
-* @param celsius temperature in celsius to convert
+* @param celsius temperature in centi-degrees celsius to convert
+*
+* @return temperature in centi-degrees of the selected unit
 */
-static float convert_temp(float celsius)
+int32_t convert_temp(int32_t celsius)
 {
     if (current_temp_unit == TEMP_FAHRENHEIT)
     {
-        return (celsius * 9.0f / 5.0f) + 32.0f;
+        return celsius_to_fahrenheit_centi(celsius);
     }
     return celsius;
 }
 
 /**
-* @brief convert a temperature from celcius to farenheit if needed
-*
-* @param celsius temperature in celsius to convert
+* @brief get the symbol of the selected temperature unit ('C' or 'F')
 */
-static char get_unit_symbol(void)
+char get_unit_symbol(void)
 {
     return (current_temp_unit == TEMP_FAHRENHEIT) ? 'F' : 'C';
 }
@@ -74,9 +160,9 @@ static char get_unit_symbol(void)
 /**
 * @brief set a mock temperature for the ui to read
 *
-* @param temp temperature to set
+* @param temp temperature to set in centi-degrees celsius
 */
-void set_mock_temp(float temp)
+void set_mock_temp(int32_t temp)
 {
     mock_temp = temp;
     mock_sensor = true;
@@ -86,9 +172,9 @@ void set_mock_temp(float temp)
 /**
 * @brief set a mock humidity for the ui to read
 *
-* @param humid humidity to set
+* @param humid humidity to set in centi-percent
 */
-void set_mock_humid(float humid)
+void set_mock_humid(int32_t humid)
 {
     mock_humid = humid;
     mock_sensor = true;
@@ -105,39 +191,230 @@ void set_mock_sensor(bool mock_status)
 }
 
 /**
-* @brief Gets sensor data and stores a temperature, humidity and temp unit
+* @brief Arm the alarm that moves MEASURING or BACKOFF on
+*
+* If no alarm slot is free nothing would ever wake the state machine, so
+* the sample is abandoned and the next timer tick starts afresh
+*
+* @param ms delay before the next step
+*
+* @return false if the alarm could not be armed
+*/
+static bool arm_poll(uint32_t ms)
+{
+    if (add_alarm_in_ms(ms, sensor_poll_callback, NULL, true) > 0)
+    {
+        return true;
+    }
+    sensor_stats.alarm_failures++;
+    sensor_state = SENSOR_IDLE;
+    return false;
+}
+
+/**
+* @brief Start a measurement and arm the first busy check
+*
+* @return true if the trigger was accepted by the sensor
+*/
+static bool start_measurement(void)
+{
+    if (dht20_trigger() != DHT20_OK)
+    {
+        return false;
+    }
+    sensor_polls = 0;
+    sensor_state = SENSOR_MEASURING;
+    arm_poll(DHT20_MEASURE_TIME_MS);
+    return true;
+}
+
+/**
+* @brief Handle a failed attempt: back off and retry, or drop the sample
+*
+* Backoff doubles per attempt (10, 20, 40 ms) so a glitch on the shared
+* bus costs one retry rather than a bogus reading
+*/
+static void retry_measurement(void)
+{
+    if (sensor_attempt >= SENSOR_MAX_RETRIES)
+    {
+        sensor_stats.failures++;
+        sensor_state = SENSOR_IDLE;
+        return;
+    }
+
+    sensor_stats.retries++;
+    sensor_state = SENSOR_BACKOFF;
+    arm_poll(SENSOR_RETRY_BACKOFF_MS << sensor_attempt);
+    sensor_attempt++;
+}
+
+/**
+* @brief Advance the DHT20 measurement state machine by one step
 *
-* function only checks sensor data if the sensor_data_ready flag is set
-* function checks if mock mode is enabled and collects values accordingly
+* Every step is a short I2C transfer, so the caller never waits on
+* the sensor's conversion time
 *
-* @param temp location to store the temperature value
-* @param humidity location to store the humidity value
-* @param temp_unit location to store the temperature unit
+* @param humidity location to store the humidity in centi-percent
+* @param temp_celsius location to store the temperature in centi-degrees celsius
 *
-* @return true if sensor data was read, false if sensor data was not read
+* @return true if a validated measurement was collected
 */
-bool read_sensor_data(float* temp, float* humidity, char* temp_unit)
+static bool step_measurement(int32_t* humidity, int32_t* temp_celsius)
 {
-    if (sensor_data_ready)
+    switch (sensor_state)
     {
-        // check for mock mode otherwise read real sensor data
-        if (mock_sensor)
+    case SENSOR_IDLE:
+        if (measure_due)
         {
-            *temp = mock_temp;
-            *humidity = mock_humid;
+            measure_due = false;
+            sensor_attempt = 0;
+            if (!start_measurement())
+            {
+                retry_measurement();
+            }
         }
-        else
+        return false;
+
+    case SENSOR_BACKOFF:
+        if (!poll_due)
         {
-            float temp_celsius;
-            dht20_read(humidity, &temp_celsius);
-            // Convert temperature based on user preference
-            *temp = convert_temp(temp_celsius);
+            return false;
         }
-        *temp_unit = get_unit_symbol();
-        sensor_data_ready = false;
+        poll_due = false;
+        if (!start_measurement())
+        {
+            retry_measurement();
+        }
+        return false;
 
-        return true;
+    case SENSOR_MEASURING:
+        if (!poll_due)
+        {
+            return false;
+        }
+        poll_due = false;
+
+        int busy = dht20_poll();
+        if (busy > 0 && ++sensor_polls <= DHT20_MAX_POLLS)
+        {
+            // check the busy bit again shortly
+            arm_poll(DHT20_POLL_INTERVAL_MS);
+            return false;
+        }
+
+        if (busy > 0)
+        {
+            dht20_busy_timeout();
+        }
+        else if (busy == DHT20_OK && dht20_collect(humidity, temp_celsius) == DHT20_OK)
+        {
+            sensor_stats.samples++;
+            sensor_state = SENSOR_IDLE;
+            return true;
+        }
+
+        retry_measurement();
+        return false;
     }
 
     return false;
 }
+
+/**
+* @brief Get the sample, retry and failure counters of the sensor task
+*/
+const sensor_task_stats_t* get_sensor_task_stats(void)
+{
+    return &sensor_stats;
+}
+
+/**
+* @brief Acquisition step: advance the measurement and queue finished samples
+*
+* function never blocks: the timer tick starts a measurement and later
+* calls collect it once the sensor reports it is no longer busy
+* function checks if mock mode is enabled and collects values accordingly;
+* sensor readings pass through the median filter, mock values do not
+*/
+void sensor_task_poll(void)
+{
+    sensor_sample_t sample;
+
+    // check for mock mode otherwise read real sensor data
+    if (mock_sensor)
+    {
+        if (!measure_due)
+        {
+            return;
+        }
+        measure_due = false;
+        sample.temp = mock_temp;
+        sample.humidity = mock_humid;
+    }
+    else if (!step_measurement(&sample.humidity, &sample.temp))
+    {
+        return;
+    }
+    else if (!sample_filter_apply(&sample))
+    {
+        // bus glitch outlier: drop it before it reaches the queue
+        return;
+    }
+
+    sample.timestamp_ms = to_ms_since_boot(get_absolute_time());
+    if (sample_queue_push(&sample))
+    {
+        event_post(EVENT_SAMPLE_READY);
+    }
+}
+
+/**
+* @brief Drain queued sensor samples in arrival order
+*
+* Samples carry temperature in centi-degrees celsius; use convert_temp()
+* and get_unit_symbol() for display
+*
+* @param samples location to store the samples
+* @param max capacity of samples
+*
+* @return number of samples read, 0 if no new data
+*/
+size_t read_sensor_data(sensor_sample_t* samples, size_t max)
+{
+    return sample_queue_drain(samples, max);
+}
+
+#if SENSOR_MULTICORE
+/**
+* @brief core1 entry: run the acquisition loop forever
+*
+* core1 owns DHT20 sampling and validation and hands samples to core0
+* through the sample queue, posting EVENT_SAMPLE_READY to wake it. Timer
+* callbacks still run on core0 and wake this core with __sev(), so it
+* sleeps in __wfe() between steps.
+*
+* core1 runs from flash, so it lets core0 park it while the sample store
+* erases or programs a page.
+*/
+static void sensor_core1_main(void)
+{
+    flash_safe_execute_core_init();
+
+    while (true)
+    {
+        sensor_task_poll();
+        __wfe();
+    }
+}
+
+/**
+* @brief start the acquisition loop on core1
+*
+* After this call core0 must not call sensor_task_poll()
+*/
+void sensor_task_launch_core1(void)
+{
+    multicore_launch_core1(sensor_core1_main);
+}
+#endif
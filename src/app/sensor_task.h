@@ -1,5 +1,14 @@
 #pragma once
 
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "sample_queue.h"
+
+// Acquisition rate; the DHT20 needs 80 ms per conversion
+#define SENSOR_DEFAULT_RATE_HZ 1
+#define SENSOR_MAX_RATE_HZ 10
+
 // Temperature unit enum
 typedef enum
 {
@@ -7,10 +16,29 @@ typedef enum
     TEMP_FAHRENHEIT
 } temp_unit_t;
 
-bool read_sensor_data(float* temp, float* humidity, char* temp_unit);
+// Acquisition counters (error classes are counted by the DHT20 driver)
+typedef struct
+{
+    uint32_t samples;   // validated measurements delivered
+    uint32_t retries;   // attempts repeated after a failure
+    uint32_t failures;  // samples dropped after all retries failed
+    uint32_t alarm_failures;  // samples abandoned because no alarm slot was free
+} sensor_task_stats_t;
+
+size_t read_sensor_data(sensor_sample_t* samples, size_t max);
 
 void init_sensor_task(void);
-void set_mock_temp(float temp);
-void set_mock_humid(float humid);
+void sensor_task_poll(void);
+#if SENSOR_MULTICORE
+void sensor_task_launch_core1(void);
+#endif
+int32_t convert_temp(int32_t celsius);
+char get_unit_symbol(void);
+void set_mock_temp(int32_t temp);
+void set_mock_humid(int32_t humid);
 void set_mock_sensor(bool mock_status);
 void set_temp_unit(uint8_t unit);
+void set_sample_rate_hz(uint8_t hz);
+temp_unit_t get_temp_unit(void);
+bool get_mock_sensor(void);
+const sensor_task_stats_t* get_sensor_task_stats(void);
@@ -1,82 +1,300 @@
 #include <stdio.h>
-#include <math.h>
 #include "ui.h"
+#include "fixed_point.h"
 #include "led_strip.h"
+#include "rolling_stats.h"
+#include "psychro.h"
+#include "alarm.h"
+#include "led_anim.h"
 
 
-// G-R-B:
-// 0xGGRRBB
-#define PURPLE 0x00050E
-#define BLUE 0x000011
-#define TEAL 0x110011
-#define GREEN 0x110000
-#define YELLOW 0x111100
-#define ORANGE 0x051100
-#define RED 0x001100
+// Perceptual R-G-B (0xRRGGBB); led_anim applies brightness and gamma
+#define PURPLE 0x8000FF
+#define BLUE 0x0000FF
+#define TEAL 0x00FFFF
+#define GREEN 0x00FF00
+#define YELLOW 0xFFFF00
+#define ORANGE 0xFF8000
+#define RED 0xFF0000
 
-#define BLACK 0x000000
+// Temerature Levels (in centi-degrees Fahrenheit):
+#define TEMP_VERY_COLD (16 * CENTI_PER_UNIT)
+#define TEMP_COLD (32 * CENTI_PER_UNIT)
+#define TEMP_COOL (48 * CENTI_PER_UNIT)
+#define TEMP_MILD (64 * CENTI_PER_UNIT)
+#define TEMP_HOT (80 * CENTI_PER_UNIT)
+#define TEMP_VERY_HOT (96 * CENTI_PER_UNIT)
 
-// Temerature Levels (in degrees Fahrenheit):
-#define TEMP_VERY_COLD 16
-#define TEMP_COLD 32
-#define TEMP_COOL 48
-#define TEMP_MILD 64
-#define TEMP_HOT 80
-#define TEMP_VERY_HOT 96
+#define HUMIDITY_MAX (100 * CENTI_PER_UNIT)
+
+// Humidity per LED in PWM mode; the last LED only lights at 100 %
+#define HUMIDITY_PER_LED (HUMIDITY_MAX / (NUM_LEDS - 1))
+
+// LED mask per whole percent of humidity, rounded up, built by ui_init()
+static uint8_t humidity_masks[101];
+
+static int32_t last_humidity = 0;
+
+/**
+ * @brief Fill the humidity-to-mask table
+ *
+ * Percent p lights ceil(p * 5 / 100) LEDs. Indexing by the percent
+ * rounded up gives the same count as rounding up from centi-percent.
+ * The 6th LED needs exactly 100 %, so it is not in the table.
+ */
+static void build_humidity_masks(void)
+{
+    for (uint8_t p = 0; p <= 100; p++)
+    {
+        uint8_t num_leds_on = (uint8_t)((p * (NUM_LEDS - 1) + 99) / 100);
+        humidity_masks[p] = (uint8_t)((1u << num_leds_on) - 1);
+    }
+}
 
 /**
  * @brief Updates the LED array to display new humidity
- * @param humidity The new humidity to set
+ *
+ * On/off mode is one table lookup and one masked GPIO write. PWM mode
+ * lights each full step and gives the top LED a level proportional to
+ * the remainder; both are constant time.
+ *
+ * @param humidity The new humidity to set in centi-percent
  */
-static void update_led_array(float humidity)
+static void update_led_array(int32_t humidity)
 {
     // clamp humidity to [0, 100]
-    if (humidity < 0.0f)
-        humidity = 0.0f;
-    if (humidity > 100.0f)
-        humidity = 100.0f;
+    if (humidity < 0)
+        humidity = 0;
+    if (humidity > HUMIDITY_MAX)
+        humidity = HUMIDITY_MAX;
+    last_humidity = humidity;
+
+    if (!led_pwm_enabled())
+    {
+        uint8_t mask = humidity_masks[(humidity + CENTI_PER_UNIT - 1) / CENTI_PER_UNIT];
+        if (humidity >= HUMIDITY_MAX)
+            mask |= 1u << (NUM_LEDS - 1);
+        led_write_mask(mask);
+        return;
+    }
+
+    uint16_t levels[NUM_LEDS];
+    for (uint8_t i = 0; i < NUM_LEDS - 1; i++)
+    {
+        int32_t part = humidity - i * HUMIDITY_PER_LED;
+        if (part < 0)
+            part = 0;
+        if (part > HUMIDITY_PER_LED)
+            part = HUMIDITY_PER_LED;
+        levels[i] = (uint16_t)(part * LED_PWM_LEVELS / HUMIDITY_PER_LED);
+    }
+    levels[NUM_LEDS - 1] = (humidity >= HUMIDITY_MAX) ? LED_PWM_LEVELS : 0;
+    led_write_levels(levels);
+}
+
+/**
+ * @brief Choose on/off steps or PWM levels for the humidity LED array
+ * @param enable true for PWM levels
+ */
+void set_led_array_pwm(bool enable)
+{
+    if (enable == led_pwm_enabled())
+        return;
+    led_set_pwm(enable);
+    update_led_array(last_humidity);
+}
+
+bool get_led_array_pwm(void)
+{
+    return led_pwm_enabled();
+}
+
+static lcd_field_t lcd_fields[2] = {LCD_FIELD_TEMP, LCD_FIELD_HUMIDITY};
 
-    // convert humidity to number of LEDs
-    uint8_t num_leds_on = (uint8_t)ceil(((humidity / 100.0f) * (NUM_LEDS - 1)));
+// *************************ALARMS**************************************
+static uint32_t alarm_cursor = 0;   // next alarm event for the UI
+static int8_t banner_rule = -1;     // rule shown on the LCD, -1 for none
 
-    uint8_t i = 0;
+/**
+ * @brief Reads new alarm events and picks the rule to show
+ *
+ * The newest alarm to fire is shown; when it clears, the banner falls
+ * back to any other active rule
+ */
+static void update_alarm_banner(void)
+{
+    alarm_event_t ev;
 
-    // set appropriate leds on
-    for (; i < num_leds_on; i++)
+    while (alarm_event_read(&alarm_cursor, &ev))
     {
-        led_on(leds[i]);
+        if (ev.fired)
+            banner_rule = (int8_t)ev.rule;
+        else if (ev.rule == banner_rule)
+            banner_rule = -1;
     }
 
-    // clear remaining leds
-    for (; i < NUM_LEDS; i++)
+    uint32_t active = alarm_active_mask();
+    if (banner_rule < 0 && active != 0)
     {
-        led_off(leds[i]);
+        for (uint8_t i = 0; i < ALARM_MAX_RULES; i++)
+        {
+            if (active & (1u << i))
+            {
+                banner_rule = (int8_t)i;
+                break;
+            }
+        }
     }
+}
+
+/**
+ * @brief Formats the alarm banner, e.g. "ALARM 0 temp high"
+ * @param line destination, 17 bytes
+ * @return true if an alarm is active and the banner was written
+ */
+static bool format_alarm_banner(char* line)
+{
+    alarm_rule_t rule;
+
+    if (banner_rule < 0 || !alarm_get_rule((uint8_t)banner_rule, &rule))
+        return false;
+
+    snprintf(line, 17, "ALARM %d %s %s", banner_rule,
+             alarm_channel_name(rule.channel), alarm_kind_name(rule.kind));
+    return true;
+}
+
+/**
+ * @brief Formats one LCD line for a metric
+ * @param line destination, 17 bytes
+ * @param field metric to show
+ * @param humidity The humidity in centi-percent
+ * @param temp The temperature in centi-degrees (unit given by temp_unit)
+ * @param temp_unit The unit symbol for the temperature (e.g. 'C' or 'F')
+ */
+static void format_lcd_field(char* line, lcd_field_t field, int32_t humidity, int32_t temp, char temp_unit)
+{
+    char text[12];
+    int32_t celsius = (temp_unit == 'F') ? fahrenheit_to_celsius_centi(temp) : temp;
+    int32_t derived;
 
-    // set 6th led if humidity is 100%
-    if (humidity >= 100.0f)
-        led_on(leds[NUM_LEDS - 1]);
+    switch (field)
+    {
+    case LCD_FIELD_HUMIDITY:
+        fixed_format_tenths(text, sizeof(text), humidity);
+        snprintf(line, 17, "Hum : %4s %%   ", text);
+        return;
+
+    case LCD_FIELD_DEW_POINT:
+    case LCD_FIELD_HEAT_INDEX:
+        derived = (field == LCD_FIELD_DEW_POINT) ? psychro_dew_point(celsius, humidity)
+                                                 : psychro_heat_index(celsius, humidity);
+        if (temp_unit == 'F')
+            derived = celsius_to_fahrenheit_centi(derived);
+        fixed_format_tenths(text, sizeof(text), derived);
+        snprintf(line, 17, "%s: %4s %c   ", (field == LCD_FIELD_DEW_POINT) ? "Dew " : "Heat", text, temp_unit);
+        return;
+
+    case LCD_FIELD_ABS_HUMIDITY:
+        fixed_format_tenths(text, sizeof(text), psychro_abs_humidity(celsius, humidity));
+        snprintf(line, 17, "AbsH: %4s g/m3", text);
+        return;
+
+    case LCD_FIELD_TEMP:
+    default:
+        fixed_format_tenths(text, sizeof(text), temp);
+        snprintf(line, 17, "Temp: %4s %c   ", text, temp_unit);
+        return;
+    }
 }
 
 /**
- * @brief Updates the LCD to display a new temperature and humidity
- * @param humidity The new humidity to set
- * @param temp The new temperature to set
+ * @brief Updates the LCD to display a new temperature and humidity, or the
+ * derived metrics selected with set_lcd_field()
+ * @param humidity The new humidity to set in centi-percent
+ * @param temp The new temperature to set in centi-degrees
  * @param temp_unit The unit symbol for the temperature (e.g. 'C' or 'F')
  */
-static void update_lcd(float humidity, float temp, char temp_unit)
+static void update_lcd(int32_t humidity, int32_t temp, char temp_unit)
 {
     char line1[17];
     char line2[17];
 
     // 16-char lines (pad with spaces to overwrite old characters)
-    snprintf(line1, sizeof(line1), "Temp: %4.1f %c   ", temp, temp_unit);
-    snprintf(line2, sizeof(line2), "Hum : %4.1f %%   ", humidity);
+    format_lcd_field(line1, lcd_fields[0], humidity, temp, temp_unit);
+    format_lcd_field(line2, lcd_fields[1], humidity, temp, temp_unit);
+
+    lcd_frame_set_line(0, line1);
+    format_alarm_banner(line2);   // an active alarm replaces line 2
+    lcd_frame_set_line(1, line2);
+    lcd_frame_commit();
+}
+
+/**
+ * @brief Updates the LCD with the smoothed view: moving average, then the
+ * min-max of the rolling window
+ * @param temp_unit The unit symbol for the temperature (e.g. 'C' or 'F')
+ */
+static void update_lcd_smooth(char temp_unit)
+{
+    rolling_summary_t temp;
+    rolling_summary_t humidity;
+    char line1[17];
+    char line2[17];
+    char text[3][12];
+
+    if (!rolling_stats_get(ROLLING_TEMP, &temp) || !rolling_stats_get(ROLLING_HUMIDITY, &humidity))
+    {
+        return;
+    }
+
+    if (temp_unit == 'F')
+    {
+        temp.ema = celsius_to_fahrenheit_centi(temp.ema);
+        temp.min = celsius_to_fahrenheit_centi(temp.min);
+        temp.max = celsius_to_fahrenheit_centi(temp.max);
+    }
+
+    // e.g. "~72.3F 71.8-72.9"
+    fixed_format_tenths(text[0], sizeof(text[0]), temp.ema);
+    fixed_format_tenths(text[1], sizeof(text[1]), temp.min);
+    fixed_format_tenths(text[2], sizeof(text[2]), temp.max);
+    snprintf(line1, sizeof(line1), "~%s%c %s-%s", text[0], temp_unit, text[1], text[2]);
+
+    fixed_format_tenths(text[0], sizeof(text[0]), humidity.ema);
+    fixed_format_tenths(text[1], sizeof(text[1]), humidity.min);
+    fixed_format_tenths(text[2], sizeof(text[2]), humidity.max);
+    snprintf(line2, sizeof(line2), "~%s%% %s-%s", text[0], text[1], text[2]);
+
+    // lcd_frame_set_line pads short lines with spaces
+    lcd_frame_set_line(0, line1);
+    format_alarm_banner(line2);   // an active alarm replaces line 2
+    lcd_frame_set_line(1, line2);
+    lcd_frame_commit();
+}
 
-    lcd_set_cursor(0, 0);
-    lcd_print(line1);
-    lcd_set_cursor(0, 1);
-    lcd_print(line2);
+static lcd_view_t curr_lcd_view = LCD_VIEW_RAW;
+
+void set_lcd_view(lcd_view_t view) {
+    curr_lcd_view = view;
+}
+
+lcd_view_t get_lcd_view(void) {
+    return curr_lcd_view;
+}
+
+/**
+ * @brief Choose the metric shown on a line of the raw view
+ * @param line 0 or 1
+ * @param field metric to show
+ */
+void set_lcd_field(uint8_t line, lcd_field_t field) {
+    if (line < 2)
+        lcd_fields[line] = field;
+}
+
+lcd_field_t get_lcd_field(uint8_t line) {
+    return lcd_fields[line < 2 ? line : 0];
 }
 
 
@@ -87,29 +305,67 @@ void set_led_strip_pattern(uint8_t pattern) {
     curr_led_pattern = pattern;
 }
 
+uint8_t get_led_strip_pattern(void) {
+    return curr_led_pattern;
+}
+
+// Color gradient stops at the middle of each temperature band
+// (centi-degrees Fahrenheit), ascending
+static const struct
+{
+    int32_t temp;
+    uint32_t rgb;
+} temp_gradient[] = {
+    {  8 * CENTI_PER_UNIT, PURPLE },
+    { 24 * CENTI_PER_UNIT, BLUE },
+    { 40 * CENTI_PER_UNIT, TEAL },
+    { 56 * CENTI_PER_UNIT, GREEN },
+    { 72 * CENTI_PER_UNIT, YELLOW },
+    { 88 * CENTI_PER_UNIT, ORANGE },
+};
+
+#define TEMP_GRADIENT_STOPS (sizeof(temp_gradient) / sizeof(temp_gradient[0]))
+
 /**
- * @brief Get WS2812 color from temperature value
- * @param temp Temperature in Fahrenheit
- * @return 32-bit GRB color value (0xGGRRBB format)
+ * @brief Get strip color from temperature value
+ *
+ * Interpolates between the two nearest gradient stops, per channel, so
+ * the color moves smoothly instead of jumping at band edges
+ *
+ * @param temp Temperature in centi-degrees Fahrenheit
+ * @return perceptual color (0xRRGGBB format)
  * @private
  */
-static uint32_t get_temp_color(float temp) {
-    if (temp < TEMP_VERY_COLD)      return PURPLE;
-    else if (temp < TEMP_COLD)      return BLUE;
-    else if (temp < TEMP_COOL)      return TEAL;
-    else if (temp < TEMP_MILD)      return GREEN;
-    else if (temp < TEMP_HOT)       return YELLOW;
-    else if (temp < TEMP_VERY_HOT)  return ORANGE;
-    else                            return RED;
+static uint32_t get_temp_color(int32_t temp) {
+    if (temp <= temp_gradient[0].temp)
+        return temp_gradient[0].rgb;
+
+    for (uint8_t i = 1; i < TEMP_GRADIENT_STOPS; i++) {
+        if (temp < temp_gradient[i].temp) {
+            int32_t t0 = temp_gradient[i - 1].temp;
+            int32_t span = temp_gradient[i].temp - t0;
+            uint32_t a = temp_gradient[i - 1].rgb;
+            uint32_t b = temp_gradient[i].rgb;
+            uint32_t rgb = 0;
+
+            for (uint8_t shift = 0; shift < 24; shift += 8) {
+                int32_t ca = (int32_t)((a >> shift) & 0xFF);
+                int32_t cb = (int32_t)((b >> shift) & 0xFF);
+                rgb |= (uint32_t)(ca + (cb - ca) * (temp - t0) / span) << shift;
+            }
+            return rgb;
+        }
+    }
+    return temp_gradient[TEMP_GRADIENT_STOPS - 1].rgb;
 }
 
 /**
- * @brief Get number of LEDs to light from temperature value
- * @param temp Temperature in Celsius
- * @return uint8_t number
+ * @brief Get the part of the strip to light from temperature value
+ * @param temp Temperature in centi-degrees Fahrenheit
+ * @return eighths of the strip, 2 to 8
  * @private
  */
-static uint8_t get_num_leds_to_light(float temp) {
+static uint8_t get_num_leds_to_light(int32_t temp) {
     if (temp < TEMP_VERY_COLD)      return 2;
     else if (temp < TEMP_COLD)      return 3;
     else if (temp < TEMP_COOL)      return 4;
@@ -123,7 +379,7 @@ static uint8_t get_num_leds_to_light(float temp) {
  * @brief 
  * Pattern 1: All LEDs same color based on temperature
  * Pattern 2: Progressive fill based on temperature
- * @param temp Temperature in Fahrenheit
+ * @param temp Temperature in centi-degrees (unit given by temp_unit)
  * 
  * Progressive fill chart:
  * | Temperature | LEDs | Color  |
@@ -134,28 +390,27 @@ static uint8_t get_num_leds_to_light(float temp) {
  * | 49 to 64°F  | 5    | Green  | mild
  * | 65 to 80°F  | 6    | Yellow | hot
  * | 81 to 96°F  | 7    | Orange | very hot
- * | ≥ 96°F      | 8    | Red    | extreme heat *WARNING*
+ * | ≥ 96°F      | 8    | Orange | extreme heat
+ *
+ * LED counts are eighths of the strip length (rounded up), and every
+ * strip shows the same pattern. Colors blend between the bands, and the
+ * strip cross-fades to each new state (led_anim.h).
+ *
+ * Red is reserved for alarms: while any alarm rule is active (alarm.h,
+ * default rule temp ≥ 96°F) the lit LEDs turn red and pulse
  */
-static void update_led_strip(float temp, char temp_unit) {
+static void update_led_strip(int32_t temp, char temp_unit) {
     
     if (temp_unit == 'C') {
-        temp = (temp * 9.0f / 5.0f) + 32.0f;
-    }
-
-    uint32_t color = get_temp_color(temp);
-
-    if (curr_led_pattern == 1) {
-        // Pattern 1: All LEDs same color
-        led_strip_array_fill(color);
-    } else { 
-        // Pattern 2: Progressive fill
-        led_strip_array_clear();
-        uint8_t num_leds_to_light = get_num_leds_to_light(temp);
-        led_strip_array_fill_partial(num_leds_to_light, color);
+        temp = celsius_to_fahrenheit_centi(temp);
     }
 
-    led_strip_light();
+    bool alarm = (alarm_active_mask() != 0);
+    uint32_t color = alarm ? RED : get_temp_color(temp);
+    uint8_t fill = (curr_led_pattern == 1) ? 8 : get_num_leds_to_light(temp);
 
+    // frames are rendered by the animation task, not here
+    led_anim_set_scene(color, fill, alarm);
 }
 
 /**
@@ -167,7 +422,9 @@ void ui_init(void)
 {
     lcd_init();
     led_init();
+    build_humidity_masks();
     led_strip_init();
+    led_anim_init();
 }
 
 /**
@@ -178,10 +435,9 @@ void ui_init(void)
  */
 void ui_startup(void)
 {
-    lcd_set_cursor(0, 0);
-    lcd_print("Env Monitor");
-    lcd_set_cursor(0, 1);
-    lcd_print("Starting...");
+    lcd_frame_set_line(0, "Env Monitor");
+    lcd_frame_set_line(1, "Starting...");
+    lcd_frame_commit();
 
     // test led array
     for (uint8_t i = 0; i < NUM_LEDS; i++)
@@ -199,13 +455,17 @@ void ui_startup(void)
 /**
  * @brief Updates the UI based on a new humidity and temperature
  *
- * @param humidity The new humidity value
- * @param temp The new temperature value
+ * @param humidity The new humidity value in centi-percent
+ * @param temp The new temperature value in centi-degrees
  * @param temp_unit The unit symbol for the temperature (e.g. 'C' or 'F')
  */
-void ui_update(float humidity, float temp, char temp_unit)
+void ui_update(int32_t humidity, int32_t temp, char temp_unit)
 {
-    update_lcd(humidity, temp, temp_unit);
+    update_alarm_banner();
+    if (curr_lcd_view == LCD_VIEW_SMOOTH)
+        update_lcd_smooth(temp_unit);
+    else
+        update_lcd(humidity, temp, temp_unit);
     update_led_array(humidity);
     update_led_strip(temp, temp_unit);
 }
@@ -4,7 +4,30 @@
 #include "../drivers/led.h"
 #include "pico/stdlib.h"
 
+typedef enum
+{
+    LCD_VIEW_RAW,       // newest sample
+    LCD_VIEW_SMOOTH     // moving average and window min-max
+} lcd_view_t;
+
+// Metric shown on a line of the raw LCD view
+typedef enum
+{
+    LCD_FIELD_TEMP,
+    LCD_FIELD_HUMIDITY,
+    LCD_FIELD_DEW_POINT,
+    LCD_FIELD_HEAT_INDEX,
+    LCD_FIELD_ABS_HUMIDITY
+} lcd_field_t;
+
 void ui_init(void);
 void ui_startup(void);
-void ui_update(float humidity, float temp, char temp_unit);
-void set_led_strip_pattern(uint8_t pattern);
\ No newline at end of file
+void ui_update(int32_t humidity, int32_t temp, char temp_unit);
+void set_led_strip_pattern(uint8_t pattern);
+uint8_t get_led_strip_pattern(void);
+void set_lcd_view(lcd_view_t view);
+lcd_view_t get_lcd_view(void);
+void set_lcd_field(uint8_t line, lcd_field_t field);
+lcd_field_t get_lcd_field(uint8_t line);
+void set_led_array_pwm(bool enable);
+bool get_led_array_pwm(void);
@@ -2,33 +2,176 @@
  * @file dht20.c
  * @brief DHT20 temperature and humidity sensor driver
  *
+ * Measurements are split into trigger / poll / collect steps so callers
+ * can wait for the conversion without blocking. dht20_read() wraps the
+ * three steps for code that is happy to block.
+ *
+ * Every frame is validated (I2C length, status byte, CRC-8) and each
+ * failure class is counted in dht20_stats for diagnostics.
  */
 
 #include "dht20.h"
+#include "i2c_bus.h"
 #include "pico/stdlib.h"
 
 
 uint8_t DHT20_start_commands[3] = {0xAC, 0x33, 0x00};
+uint8_t DHT20_calibrate_commands[3] = {0xBE, 0x08, 0x00};
+
+static dht20_stats_t dht20_stats;
+
+// CRC-8, polynomial 0x31 (x^8 + x^5 + x^4 + 1), from AHT20 docs
+static const uint8_t crc8_table[256] = {
+    0x00, 0x31, 0x62, 0x53, 0xC4, 0xF5, 0xA6, 0x97,
+    0xB9, 0x88, 0xDB, 0xEA, 0x7D, 0x4C, 0x1F, 0x2E,
+    0x43, 0x72, 0x21, 0x10, 0x87, 0xB6, 0xE5, 0xD4,
+    0xFA, 0xCB, 0x98, 0xA9, 0x3E, 0x0F, 0x5C, 0x6D,
+    0x86, 0xB7, 0xE4, 0xD5, 0x42, 0x73, 0x20, 0x11,
+    0x3F, 0x0E, 0x5D, 0x6C, 0xFB, 0xCA, 0x99, 0xA8,
+    0xC5, 0xF4, 0xA7, 0x96, 0x01, 0x30, 0x63, 0x52,
+    0x7C, 0x4D, 0x1E, 0x2F, 0xB8, 0x89, 0xDA, 0xEB,
+    0x3D, 0x0C, 0x5F, 0x6E, 0xF9, 0xC8, 0x9B, 0xAA,
+    0x84, 0xB5, 0xE6, 0xD7, 0x40, 0x71, 0x22, 0x13,
+    0x7E, 0x4F, 0x1C, 0x2D, 0xBA, 0x8B, 0xD8, 0xE9,
+    0xC7, 0xF6, 0xA5, 0x94, 0x03, 0x32, 0x61, 0x50,
+    0xBB, 0x8A, 0xD9, 0xE8, 0x7F, 0x4E, 0x1D, 0x2C,
+    0x02, 0x33, 0x60, 0x51, 0xC6, 0xF7, 0xA4, 0x95,
+    0xF8, 0xC9, 0x9A, 0xAB, 0x3C, 0x0D, 0x5E, 0x6F,
+    0x41, 0x70, 0x23, 0x12, 0x85, 0xB4, 0xE7, 0xD6,
+    0x7A, 0x4B, 0x18, 0x29, 0xBE, 0x8F, 0xDC, 0xED,
+    0xC3, 0xF2, 0xA1, 0x90, 0x07, 0x36, 0x65, 0x54,
+    0x39, 0x08, 0x5B, 0x6A, 0xFD, 0xCC, 0x9F, 0xAE,
+    0x80, 0xB1, 0xE2, 0xD3, 0x44, 0x75, 0x26, 0x17,
+    0xFC, 0xCD, 0x9E, 0xAF, 0x38, 0x09, 0x5A, 0x6B,
+    0x45, 0x74, 0x27, 0x16, 0x81, 0xB0, 0xE3, 0xD2,
+    0xBF, 0x8E, 0xDD, 0xEC, 0x7B, 0x4A, 0x19, 0x28,
+    0x06, 0x37, 0x64, 0x55, 0xC2, 0xF3, 0xA0, 0x91,
+    0x47, 0x76, 0x25, 0x14, 0x83, 0xB2, 0xE1, 0xD0,
+    0xFE, 0xCF, 0x9C, 0xAD, 0x3A, 0x0B, 0x58, 0x69,
+    0x04, 0x35, 0x66, 0x57, 0xC0, 0xF1, 0xA2, 0x93,
+    0xBD, 0x8C, 0xDF, 0xEE, 0x79, 0x48, 0x1B, 0x2A,
+    0xC1, 0xF0, 0xA3, 0x92, 0x05, 0x34, 0x67, 0x56,
+    0x78, 0x49, 0x1A, 0x2B, 0xBC, 0x8D, 0xDE, 0xEF,
+    0x82, 0xB3, 0xE0, 0xD1, 0x46, 0x77, 0x24, 0x15,
+    0x3B, 0x0A, 0x59, 0x68, 0xFF, 0xCE, 0x9D, 0xAC,
+};
+
+/**
+ * @brief Compute the AHT20 CRC-8 (init 0xFF) over a buffer
+ */
+static uint8_t dht20_crc8(const uint8_t *data, size_t len) {
+    uint8_t crc = 0xFF;
+    for (size_t i = 0; i < len; i++) {
+        crc = crc8_table[crc ^ data[i]];
+    }
+    return crc;
+}
 
+/**
+ * @brief Count a failure in its error class and pass the code through
+ */
+static int dht20_fail(int err) {
+    switch (err) {
+    case DHT20_ERR_I2C:  dht20_stats.i2c_errors++;  break;
+    case DHT20_ERR_CRC:  dht20_stats.crc_errors++;  break;
+    case DHT20_ERR_BUSY: dht20_stats.busy_errors++; break;
+    case DHT20_ERR_CAL:  dht20_stats.cal_errors++;  break;
+    }
+    return err;
+}
 
 void dht20_init(void) {
     uint8_t soft_reset[] = {0xBA};  // from AHT20 docs
-    i2c_write_blocking(DHT20_PORT, DHT20_ADDR, soft_reset, 1, false);
+    i2c_bus_write_blocking(DHT20_PORT, DHT20_ADDR, soft_reset, 1, false);
     sleep_ms(20);  // time required to soft reset does not exceed 20ms
+
+    // load calibration if the sensor does not report it as enabled
+    uint8_t status;
+    if (i2c_bus_read_blocking(DHT20_PORT, DHT20_ADDR, &status, 1, false) == 1 &&
+        !(status & DHT20_STATUS_CALIBRATED)) {
+        i2c_bus_write_blocking(DHT20_PORT, DHT20_ADDR, DHT20_calibrate_commands, 3, false);
+        sleep_ms(10);
+    }
 }
 
-int dht20_read(float *humidity, float *temp) {
+/**
+ * @brief Get the per-error-class counters
+ */
+const dht20_stats_t *dht20_get_stats(void) {
+    return &dht20_stats;
+}
+
+/**
+ * @brief Start a measurement
+ *
+ * The conversion takes ~80ms (DHT20_MEASURE_TIME_MS). Call dht20_poll()
+ * after that to check whether the result is ready.
+ *
+ * @return DHT20_OK on success, DHT20_ERR_I2C on I2C error
+ */
+int dht20_trigger(void) {
     // send wakup command to the sensor
-    i2c_write_blocking(DHT20_PORT, DHT20_ADDR, DHT20_start_commands, 3, false);
-    sleep_ms(80);       // DHT20 needs 80ms
+    int result = i2c_bus_write_blocking(DHT20_PORT, DHT20_ADDR, DHT20_start_commands, 3, false);
+    return (result == 3) ? DHT20_OK : dht20_fail(DHT20_ERR_I2C);
+}
 
+/**
+ * @brief Check whether a triggered measurement has finished
+ *
+ * Reads only the status byte and tests the busy bit.
+ *
+ * @return 1 if still busy, DHT20_OK if ready, DHT20_ERR_I2C on I2C error
+ */
+int dht20_poll(void) {
+    uint8_t status;
+    int result = i2c_bus_read_blocking(DHT20_PORT, DHT20_ADDR, &status, 1, false);
+    if (result != 1) {
+        return dht20_fail(DHT20_ERR_I2C);
+    }
+    return (status & DHT20_STATUS_BUSY) ? 1 : DHT20_OK;
+}
+
+/**
+ * @brief Record a measurement that never left the busy state
+ *
+ * Called by the owner of the poll loop when it gives up waiting
+ *
+ * @return DHT20_ERR_BUSY
+ */
+int dht20_busy_timeout(void) {
+    return dht20_fail(DHT20_ERR_BUSY);
+}
+
+/**
+ * @brief Read and convert the result of a finished measurement
+ *
+ * @param humidity location to store relative humidity in centi-percent
+ * @param temp location to store temperature in centi-degrees celsius
+ *
+ * @return DHT20_OK on success, or the DHT20_ERR_* class of the failure
+ */
+int dht20_collect(int32_t *humidity, int32_t *temp) {
     // Response is 7 bytes:
         // first byte is status
         // next 20 bits is humidity
         // the following 20 bits is temp
         // last byte is CRC data
     uint8_t sensor_data[7];
-    int result = i2c_read_blocking(DHT20_PORT, DHT20_ADDR, sensor_data, 7, false);
+    int result = i2c_bus_read_blocking(DHT20_PORT, DHT20_ADDR, sensor_data, 7, false);
+    if (result != 7) {
+        return dht20_fail(DHT20_ERR_I2C);
+    }
+
+    // validate the frame before trusting any of it
+    if (dht20_crc8(sensor_data, 6) != sensor_data[6]) {
+        return dht20_fail(DHT20_ERR_CRC);
+    }
+    if (sensor_data[0] & DHT20_STATUS_BUSY) {
+        return dht20_fail(DHT20_ERR_BUSY);
+    }
+    if (!(sensor_data[0] & DHT20_STATUS_CALIBRATED)) {
+        return dht20_fail(DHT20_ERR_CAL);
+    }
 
     // Extract the raw values
     // store in 32-bit variables
@@ -47,9 +190,42 @@ int dht20_read(float *humidity, float *temp) {
     uint32_t temp_raw_final = temp_raw_1 | temp_raw_2 | temp_raw_3;
 
 
-    // Convert to floats (full equation is from the docs)
-    *humidity = ((float)humidity_raw_final / 1048576.0f) * 100.0f;
-    *temp = (((float)temp_raw_final / 1048576.0f) * 200 - 50.0f);
+    // Convert to centi-units (full equation is from the docs):
+    //   RH[%] = raw / 2^20 * 100  ->  raw * 10000 / 2^20 = raw * 625 / 2^16
+    //   T[C]  = raw / 2^20 * 200 - 50  ->  raw * 625 / 2^15 - 5000
+    // raw * 625 stays below 2^30, so 32-bit math is enough
+    *humidity = (int32_t)((humidity_raw_final * 625u + (1u << 15)) >> 16);
+    *temp = (int32_t)((temp_raw_final * 625u + (1u << 14)) >> 15) - 5000;
+
+    dht20_stats.reads_ok++;
+    return DHT20_OK;
+}
+
+/**
+ * @brief Blocking measurement: trigger, wait for the busy bit to clear, collect
+ *
+ * @param humidity location to store relative humidity in centi-percent
+ * @param temp location to store temperature in centi-degrees celsius
+ *
+ * @return DHT20_OK on success, or the DHT20_ERR_* class of the failure
+ */
+int dht20_read(int32_t *humidity, int32_t *temp) {
+    int result = dht20_trigger();
+    if (result < 0) {
+        return result;
+    }
+    sleep_ms(DHT20_MEASURE_TIME_MS);
+
+    uint8_t polls = 0;
+    while ((result = dht20_poll()) > 0) {
+        if (++polls > DHT20_MAX_POLLS) {
+            return dht20_busy_timeout();
+        }
+        sleep_ms(DHT20_POLL_INTERVAL_MS);
+    }
+    if (result < 0) {
+        return result;
+    }
 
-    return 0;
+    return dht20_collect(humidity, temp);
 }
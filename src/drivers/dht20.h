@@ -13,6 +13,45 @@
 #define DHT20_ADDR 0x38
 #define DHT20_PORT i2c0
 
+#define DHT20_STATUS_BUSY 0x80        // status bit 7: measurement in progress
+#define DHT20_STATUS_CALIBRATED 0x08  // status bit 3: calibration enabled
+#define DHT20_MEASURE_TIME_MS 80      // typical conversion time from the docs
+#define DHT20_POLL_INTERVAL_MS 5      // re-check interval while still busy
+#define DHT20_MAX_POLLS 20            // busy re-checks before giving up
+
+// Return codes, one per error class
+#define DHT20_OK 0
+#define DHT20_ERR_I2C -1    // NACK or short transfer
+#define DHT20_ERR_CRC -2    // CRC-8 mismatch
+#define DHT20_ERR_BUSY -3   // sensor never finished the measurement
+#define DHT20_ERR_CAL -4    // sensor reports it is not calibrated
+
+// Per-error-class counters
+typedef struct {
+    uint32_t reads_ok;
+    uint32_t i2c_errors;
+    uint32_t crc_errors;
+    uint32_t busy_errors;
+    uint32_t cal_errors;
+} dht20_stats_t;
 
 void dht20_init(void);
-int dht20_read(float *humidity, float *temp);
+int dht20_trigger(void);
+int dht20_poll(void);
+int dht20_busy_timeout(void);
+int dht20_collect(int32_t *humidity, int32_t *temp);
+int dht20_read(int32_t *humidity, int32_t *temp);
+const dht20_stats_t *dht20_get_stats(void);
+
+#ifdef DHT20_FLOAT_COMPAT
+// Compatibility shim for callers that still want percent / celsius floats
+static inline int dht20_read_float(float *humidity, float *temp) {
+    int32_t humidity_centi, temp_centi;
+    int result = dht20_read(&humidity_centi, &temp_centi);
+    if (result == DHT20_OK) {
+        *humidity = humidity_centi / 100.0f;
+        *temp = temp_centi / 100.0f;
+    }
+    return result;
+}
+#endif
@@ -0,0 +1,33 @@
+/**
+ * @file flash_backend.h
+ * @brief NOR flash access used by the sample store
+ *
+ * Offsets are relative to the start of the store's region. Backends must
+ * behave like NOR flash: erase sets a whole sector to 0xFF, and program
+ * can only clear bits within an erased page.
+ *
+ * flash_backend_rp2040 (flash_backend_rp2040.c) is the firmware backend.
+ * flash_backend_file_open() (flash_backend_file.c) is a host stand-in
+ * backed by an image file. It is not part of the firmware build.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define FLASH_STORE_SECTOR_SIZE 4096   // erase unit
+#define FLASH_STORE_PAGE_SIZE 256      // program unit
+#define FLASH_STORE_SECTORS 64         // 256 KB at the end of flash
+
+typedef struct
+{
+    uint32_t size;                                              // region size in bytes
+    bool (*read)(uint32_t offset, void* buf, size_t len);
+    bool (*erase_sector)(uint32_t offset);                      // offset sector aligned
+    bool (*program_page)(uint32_t offset, const void* page);    // one full page
+} flash_backend_t;
+
+extern const flash_backend_t flash_backend_rp2040;
+const flash_backend_t* flash_backend_file_open(const char* path, uint32_t size);
@@ -0,0 +1,108 @@
+/**
+ * @file flash_backend_file.c
+ * @brief Host stand-in for the flash backend, backed by an image file
+ *
+ * Not part of the firmware build. tests/host/test_flash_store.c builds it
+ * with the store on Linux to exercise the store against a persistent image.
+ *
+ * NOR semantics are emulated: erase fills a sector with 0xFF and program
+ * ANDs data into the page, so a page programmed twice shows the same
+ * corruption real flash would. A missing or short image is extended with
+ * erased (0xFF) bytes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "flash_backend.h"
+
+static FILE* image = NULL;
+static uint32_t image_size = 0;
+
+static bool file_read(uint32_t offset, void* buf, size_t len)
+{
+    if (offset + len > image_size || fseek(image, (long)offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    return fread(buf, 1, len, image) == len;
+}
+
+static bool file_erase_sector(uint32_t offset)
+{
+    uint8_t erased[FLASH_STORE_SECTOR_SIZE];
+
+    if (offset % FLASH_STORE_SECTOR_SIZE != 0 || offset >= image_size)
+    {
+        return false;
+    }
+    memset(erased, 0xFF, sizeof(erased));
+    if (fseek(image, (long)offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    return fwrite(erased, 1, sizeof(erased), image) == sizeof(erased) && fflush(image) == 0;
+}
+
+static bool file_program_page(uint32_t offset, const void* page)
+{
+    uint8_t cells[FLASH_STORE_PAGE_SIZE];
+    const uint8_t* data = page;
+
+    if (offset % FLASH_STORE_PAGE_SIZE != 0 || !file_read(offset, cells, sizeof(cells)))
+    {
+        return false;
+    }
+    for (size_t i = 0; i < sizeof(cells); i++)
+    {
+        cells[i] &= data[i];   // programming can only clear bits
+    }
+    if (fseek(image, (long)offset, SEEK_SET) != 0)
+    {
+        return false;
+    }
+    return fwrite(cells, 1, sizeof(cells), image) == sizeof(cells) && fflush(image) == 0;
+}
+
+static const flash_backend_t file_backend = {
+    .read = file_read,
+    .erase_sector = file_erase_sector,
+    .program_page = file_program_page,
+};
+
+/**
+ * @brief open (or create) an image file and use it as the flash region
+ *
+ * @param path image file
+ * @param size region size in bytes, a multiple of the sector size
+ *
+ * @return backend, or NULL if the file could not be opened
+ */
+const flash_backend_t* flash_backend_file_open(const char* path, uint32_t size)
+{
+    static flash_backend_t backend;
+
+    image = fopen(path, "r+b");
+    if (image == NULL)
+    {
+        image = fopen(path, "w+b");
+    }
+    if (image == NULL)
+    {
+        return NULL;
+    }
+
+    // extend a new or short image with erased bytes
+    fseek(image, 0, SEEK_END);
+    long length = ftell(image);
+    while (length >= 0 && (uint32_t)length < size)
+    {
+        fputc(0xFF, image);
+        length++;
+    }
+    fflush(image);
+
+    image_size = size;
+    backend = file_backend;
+    backend.size = size;
+    return &backend;
+}
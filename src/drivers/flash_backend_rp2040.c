@@ -0,0 +1,81 @@
+/**
+ * @file flash_backend_rp2040.c
+ * @brief Sample store region in the RP2040's on-board QSPI flash
+ *
+ * The region is the last FLASH_STORE_SECTORS sectors of flash, well clear
+ * of the firmware image. Reads go straight through the XIP window. Erase
+ * and program run through flash_safe_execute(), which parks the other core
+ * (when it is running) and disables interrupts while XIP is unavailable.
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/flash.h"
+#include "hardware/flash.h"
+#include "flash_backend.h"
+
+#define REGION_SIZE (FLASH_STORE_SECTORS * FLASH_STORE_SECTOR_SIZE)
+#define REGION_OFFSET (PICO_FLASH_SIZE_BYTES - REGION_SIZE)
+#define SAFE_EXECUTE_TIMEOUT_MS 100
+
+_Static_assert(FLASH_STORE_SECTOR_SIZE == FLASH_SECTOR_SIZE, "sector size mismatch");
+_Static_assert(FLASH_STORE_PAGE_SIZE == FLASH_PAGE_SIZE, "page size mismatch");
+
+typedef struct
+{
+    uint32_t offset;
+    const void* page;
+} program_args_t;
+
+/**
+ * @brief erase one sector (runs with XIP unavailable)
+ */
+static void do_erase(void* param)
+{
+    flash_range_erase(REGION_OFFSET + (uint32_t)(uintptr_t)param, FLASH_SECTOR_SIZE);
+}
+
+/**
+ * @brief program one page (runs with XIP unavailable)
+ */
+static void do_program(void* param)
+{
+    const program_args_t* args = param;
+    flash_range_program(REGION_OFFSET + args->offset, args->page, FLASH_PAGE_SIZE);
+}
+
+static bool rp2040_read(uint32_t offset, void* buf, size_t len)
+{
+    if (offset + len > REGION_SIZE)
+    {
+        return false;
+    }
+    memcpy(buf, (const void*)(XIP_BASE + REGION_OFFSET + offset), len);
+    return true;
+}
+
+static bool rp2040_erase_sector(uint32_t offset)
+{
+    if (offset % FLASH_SECTOR_SIZE != 0 || offset >= REGION_SIZE)
+    {
+        return false;
+    }
+    return flash_safe_execute(do_erase, (void*)(uintptr_t)offset, SAFE_EXECUTE_TIMEOUT_MS) == PICO_OK;
+}
+
+static bool rp2040_program_page(uint32_t offset, const void* page)
+{
+    if (offset % FLASH_PAGE_SIZE != 0 || offset >= REGION_SIZE)
+    {
+        return false;
+    }
+    program_args_t args = { .offset = offset, .page = page };
+    return flash_safe_execute(do_program, &args, SAFE_EXECUTE_TIMEOUT_MS) == PICO_OK;
+}
+
+const flash_backend_t flash_backend_rp2040 = {
+    .size = REGION_SIZE,
+    .read = rp2040_read,
+    .erase_sector = rp2040_erase_sector,
+    .program_page = rp2040_program_page,
+};
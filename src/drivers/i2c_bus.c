@@ -0,0 +1,55 @@
+/**
+ * @file i2c_bus.c
+ * @brief Shared I2C bus access for the LCD and DHT20
+ */
+
+#include "i2c_bus.h"
+#include "pico/mutex.h"
+#include "pico/stdlib.h"
+
+static mutex_t bus_mutex;
+
+/**
+ * @brief Initialize the I2C peripheral, its pins and the bus mutex
+ *
+ * @param i2c I2C instance to initialize
+ * @param baudrate bus clock in Hz
+ * @param sda_pin GPIO used for SDA
+ * @param scl_pin GPIO used for SCL
+ */
+void i2c_bus_init(i2c_inst_t *i2c, uint baudrate, uint sda_pin, uint scl_pin)
+{
+    mutex_init(&bus_mutex);
+
+    i2c_init(i2c, baudrate);
+    gpio_set_function(sda_pin, GPIO_FUNC_I2C);
+    gpio_set_function(scl_pin, GPIO_FUNC_I2C);
+    gpio_pull_up(sda_pin);
+    gpio_pull_up(scl_pin);
+}
+
+/**
+ * @brief i2c_write_blocking() while holding the bus
+ *
+ * @return number of bytes written, or PICO_ERROR_GENERIC
+ */
+int i2c_bus_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop)
+{
+    mutex_enter_blocking(&bus_mutex);
+    int result = i2c_write_blocking(i2c, addr, src, len, nostop);
+    mutex_exit(&bus_mutex);
+    return result;
+}
+
+/**
+ * @brief i2c_read_blocking() while holding the bus
+ *
+ * @return number of bytes read, or PICO_ERROR_GENERIC
+ */
+int i2c_bus_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop)
+{
+    mutex_enter_blocking(&bus_mutex);
+    int result = i2c_read_blocking(i2c, addr, dst, len, nostop);
+    mutex_exit(&bus_mutex);
+    return result;
+}
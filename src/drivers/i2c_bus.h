@@ -0,0 +1,21 @@
+/**
+ * @file i2c_bus.h
+ * @brief Shared I2C bus access for the LCD and DHT20
+ *
+ * The LCD backpack and the DHT20 sit on the same i2c0 bus, and with the
+ * multicore build they are driven from different cores. Every transfer
+ * goes through these wrappers, which hold the bus mutex for exactly one
+ * transaction. Devices keep no bus state between transactions, so no
+ * longer ownership is needed.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "hardware/i2c.h"
+
+void i2c_bus_init(i2c_inst_t *i2c, uint baudrate, uint sda_pin, uint scl_pin);
+int i2c_bus_write_blocking(i2c_inst_t *i2c, uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+int i2c_bus_read_blocking(i2c_inst_t *i2c, uint8_t addr, uint8_t *dst, size_t len, bool nostop);
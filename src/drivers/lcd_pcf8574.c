@@ -7,6 +7,7 @@
  */
 
 #include "lcd_pcf8574.h"
+#include "i2c_bus.h"
 #include "pico/stdlib.h"
 #include <string.h>
 #include <stdio.h>
@@ -21,6 +22,12 @@
 #define I2C_MAX_RETRIES 3    ///< Max retry attempts for failed I2C writes
 #define I2C_RETRY_DELAY_MS 1 ///< Delay between retries
 
+// Nibble stream configuration
+#define LCD_BYTES_PER_NIBBLE 3                           ///< setup, E high, E low
+#define LCD_BYTES_PER_SEND (2 * LCD_BYTES_PER_NIBBLE)    ///< PCF8574 bytes per HD44780 byte
+#define LCD_STREAM_MAX_SENDS 34                          ///< two cursor moves + 32 chars
+#define LCD_STREAM_SIZE (LCD_STREAM_MAX_SENDS * LCD_BYTES_PER_SEND)
+
 // HD44780 command codes
 #define LCD_CMD_CLEAR 0x01        ///< Clear display
 #define LCD_CMD_HOME 0x02         ///< Return cursor home
@@ -33,8 +40,19 @@
 #define LCD_INIT_8BIT 0x30 ///< Force 8-bit mode
 #define LCD_INIT_4BIT 0x20 ///< Switch to 4-bit mode
 
+// Shadow framebuffer sentinel for cells whose contents are unknown
+#define LCD_CELL_UNKNOWN '\0'
+
 static uint8_t g_backlight = LCD_BACKLIGHT_BIT;
 
+// What the HD44780 currently shows, and the frame being built for it
+static char g_shadow[LCD_ROWS][LCD_COLS];
+static char g_frame[LCD_ROWS][LCD_COLS];
+
+// Pre-built PCF8574 byte stream, flushed as a single I2C transaction
+static uint8_t g_stream[LCD_STREAM_SIZE];
+static size_t g_stream_len = 0;
+
 /**
  * @brief Write a single byte to the I2C bus with retry logic
  * @param data Byte to write to PCF8574
@@ -44,7 +62,7 @@ static bool i2c_write_byte(uint8_t data)
 {
     for (int attempt = 0; attempt < I2C_MAX_RETRIES; attempt++)
     {
-        int result = i2c_write_blocking(LCD_I2C_PORT, LCD_ADDR, &data, 1, false);
+        int result = i2c_bus_write_blocking(LCD_I2C_PORT, LCD_ADDR, &data, 1, false);
 
         if (result == 1) // Success: 1 byte written
         {
@@ -62,6 +80,125 @@ static bool i2c_write_byte(uint8_t data)
     return false;
 }
 
+/**
+ * @brief Write a pre-built byte stream to the I2C bus with retry logic
+ *
+ * At 100 kHz each PCF8574 byte takes ~90us on the wire, which already
+ * exceeds the enable pulse width and the 37us HD44780 execution time,
+ * so no extra delays are needed between bytes of the stream.
+ *
+ * @param data Bytes to write to PCF8574
+ * @param len Number of bytes to write
+ * @return true if successful, false after max retries
+ */
+static bool i2c_write_stream(const uint8_t *data, size_t len)
+{
+    for (int attempt = 0; attempt < I2C_MAX_RETRIES; attempt++)
+    {
+        int result = i2c_bus_write_blocking(LCD_I2C_PORT, LCD_ADDR, data, len, false);
+
+        if (result == (int)len)
+        {
+            return true;
+        }
+
+        if (attempt < I2C_MAX_RETRIES - 1)
+        {
+            sleep_ms(I2C_RETRY_DELAY_MS);
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Push the pending nibble stream to the LCD and reset it
+ */
+static void stream_flush(void)
+{
+    if (g_stream_len > 0)
+    {
+        i2c_write_stream(g_stream, g_stream_len);
+        g_stream_len = 0;
+    }
+}
+
+/**
+ * @brief Append one 4-bit nibble with interleaved E-strobe bytes
+ * @param nibble_with_ctrl Upper nibble contains data, lower bits contain control signals
+ */
+static void stream_nibble(uint8_t nibble_with_ctrl)
+{
+    uint8_t data = nibble_with_ctrl | g_backlight;
+
+    g_stream[g_stream_len++] = data;                  // data/RS setup
+    g_stream[g_stream_len++] = data | LCD_ENABLE_BIT; // E high latches nibble
+    g_stream[g_stream_len++] = data;                  // E low
+}
+
+/**
+ * @brief Append a full 8-bit value to the nibble stream
+ *
+ * Flushes the stream first if the value would not fit.
+ *
+ * @param value 8-bit data/command
+ * @param mode_rs Register select: 0=command, LCD_RS_BIT=data
+ */
+static void stream_send(uint8_t value, uint8_t mode_rs)
+{
+    if (g_stream_len + LCD_BYTES_PER_SEND > LCD_STREAM_SIZE)
+    {
+        stream_flush();
+    }
+
+    stream_nibble((value & 0xF0) | mode_rs);
+    stream_nibble((uint8_t)((value << 4) & 0xF0) | mode_rs);
+}
+
+/**
+ * @brief Append a DDRAM address move to the nibble stream
+ * @param col Column (0-15 for 16x2 LCD)
+ * @param row Row (0-1 for 16x2 LCD)
+ */
+static void stream_set_cursor(uint8_t col, uint8_t row)
+{
+    // DDRAM addresses for 16x2 LCD
+    // Row 0: 0x00-0x0F, Row 1: 0x40-0x4F
+    static const uint8_t row_offsets[] = {0x00, 0x40};
+
+    if (row < 2 && col < 16) // Bounds check
+    {
+        stream_send(LCD_CMD_SET_DDRAM | (col + row_offsets[row]), 0);
+    }
+}
+
+/**
+ * @brief Append a null-terminated string to the nibble stream
+ * @param s String to encode (supports '\n' for second line)
+ */
+static void stream_print(const char *s)
+{
+    for (; *s != '\0'; s++)
+    {
+        if (*s == '\n')
+        {
+            stream_set_cursor(0, 1); // Move to second line
+        }
+        else
+        {
+            stream_send((uint8_t)*s, LCD_RS_BIT);
+        }
+    }
+}
+
+/**
+ * @brief Mark every shadow cell as unknown so the next commit repaints it
+ */
+static void shadow_invalidate(void)
+{
+    memset(g_shadow, LCD_CELL_UNKNOWN, sizeof(g_shadow));
+}
+
 /**
  * @brief Generate an enable pulse to latch data into LCD
  * @param data Data byte with control bits set
@@ -91,11 +228,8 @@ static void write4bits(uint8_t nibble_with_ctrl)
  */
 static void send(uint8_t value, uint8_t mode_rs)
 {
-    uint8_t high = (value & 0xF0);                // Upper nibble
-    uint8_t low = (uint8_t)((value << 4) & 0xF0); // Lower nibble shifted
-
-    write4bits(high | mode_rs);
-    write4bits(low | mode_rs);
+    stream_send(value, mode_rs);
+    stream_flush();
 }
 
 /**
@@ -107,15 +241,6 @@ static void command(uint8_t value)
     send(value, 0);
 }
 
-/**
- * @brief Write character to LCD at current cursor position (RS=1)
- * @param c Character to display
- */
-static void write_char(char c)
-{
-    send((uint8_t)c, LCD_RS_BIT);
-}
-
 /**
  * @brief Clear LCD display and return cursor to home
  */
@@ -123,6 +248,7 @@ void lcd_clear(void)
 {
     command(0x01);
     sleep_ms(2);
+    memset(g_shadow, ' ', sizeof(g_shadow));
 }
 
 /**
@@ -141,14 +267,9 @@ void lcd_home(void)
  */
 void lcd_set_cursor(uint8_t col, uint8_t row)
 {
-    // DDRAM addresses for 16x2 LCD
-    // Row 0: 0x00-0x0F, Row 1: 0x40-0x4F
-    static const uint8_t row_offsets[] = {0x00, 0x40};
-
-    if (row < 2 && col < 16) // Bounds check
-    {
-        command(LCD_CMD_SET_DDRAM | (col + row_offsets[row]));
-    }
+    stream_set_cursor(col, row);
+    stream_flush();
+    shadow_invalidate(); // Direct writes bypass the framebuffer
 }
 
 /**
@@ -160,17 +281,84 @@ void lcd_print(const char *s)
     if (!s)
         return; // Null pointer guard
 
-    for (size_t i = 0; i < strlen(s); i++)
+    stream_print(s);
+    stream_flush();
+    shadow_invalidate();
+}
+
+/**
+ * @brief Move the cursor and print a string in a single I2C transfer
+ * @param col Column (0-15 for 16x2 LCD)
+ * @param row Row (0-1 for 16x2 LCD)
+ * @param s String to display (supports '\n' for second line)
+ */
+void lcd_print_at(uint8_t col, uint8_t row, const char *s)
+{
+    if (!s)
+        return; // Null pointer guard
+
+    stream_set_cursor(col, row);
+    stream_print(s);
+    stream_flush();
+    shadow_invalidate();
+}
+
+/**
+ * @brief Set one row of the pending frame
+ *
+ * Nothing is sent until lcd_frame_commit()
+ *
+ * @param row Row (0-1 for 16x2 LCD)
+ * @param s Text for the row; truncated or padded with spaces to LCD_COLS
+ */
+void lcd_frame_set_line(uint8_t row, const char *s)
+{
+    if (row >= LCD_ROWS || !s)
+        return;
+
+    size_t len = strnlen(s, LCD_COLS);
+    memcpy(g_frame[row], s, len);
+    memset(&g_frame[row][len], ' ', LCD_COLS - len);
+}
+
+/**
+ * @brief Send the cells of the pending frame that differ from the shadow
+ *
+ * A DDRAM move is emitted only at the start of each run of changed cells;
+ * within a run the HD44780's auto-increment places the characters. The
+ * whole update goes out as one nibble stream.
+ *
+ * @return Number of cells written (0 if the frame was unchanged)
+ */
+uint8_t lcd_frame_commit(void)
+{
+    uint8_t written = 0;
+
+    for (uint8_t row = 0; row < LCD_ROWS; row++)
     {
-        if (s[i] == '\n')
-        {
-            lcd_set_cursor(0, 1); // Move to second line
-        }
-        else
+        bool in_run = false;
+
+        for (uint8_t col = 0; col < LCD_COLS; col++)
         {
-            write_char(s[i]);
+            if (g_frame[row][col] == g_shadow[row][col])
+            {
+                in_run = false;
+                continue;
+            }
+
+            if (!in_run)
+            {
+                stream_set_cursor(col, row);
+                in_run = true;
+            }
+            stream_send((uint8_t)g_frame[row][col], LCD_RS_BIT);
+            g_shadow[row][col] = g_frame[row][col];
+            written++;
         }
     }
+
+    stream_flush();
+    return written;
 }
 
 /**
@@ -222,4 +410,5 @@ void lcd_init(void)
 
     // Clear display
     lcd_clear();
+    memset(g_frame, ' ', sizeof(g_frame));
 }
\ No newline at end of file
@@ -17,6 +17,10 @@
 #define LCD_I2C_PORT i2c0
 #define LCD_ADDR 0x27 ///< PCF8574 I2C address (A0-A2 low)
 
+// Display geometry
+#define LCD_COLS 16
+#define LCD_ROWS 2
+
 // PCF8574 pin mapping to LCD
 #define LCD_RS_BIT 0x01        // P0: Register Select
 #define LCD_ENABLE_BIT 0x04    // P2: Enable pulse
@@ -28,6 +32,11 @@ void lcd_clear(void);
 void lcd_home(void);
 void lcd_set_cursor(uint8_t col, uint8_t row);
 void lcd_print(const char *s);
+void lcd_print_at(uint8_t col, uint8_t row, const char *s);
 void lcd_backlight(bool on);
 
+// Shadow framebuffer API: build a frame, then commit only the changed cells
+void lcd_frame_set_line(uint8_t row, const char *s);
+uint8_t lcd_frame_commit(void);
+
 #endif // LCD_PCF8574_H
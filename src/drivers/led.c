@@ -5,8 +5,12 @@
  */
 
 #include "led.h"
+#include "hardware/pwm.h"
 
-const uint8_t leds[] = {10, 11, 12, 13, 14, 15};
+const uint8_t leds[] = {LED_PIN_BASE, LED_PIN_BASE + 1, LED_PIN_BASE + 2,
+                        LED_PIN_BASE + 3, LED_PIN_BASE + 4, LED_PIN_BASE + 5};
+
+static bool pwm_mode = false;
 
 /**
  * @brief Initialize the LED array 
@@ -37,3 +41,68 @@ void led_off(uint8_t led_pin)
 {
     gpio_put(led_pin, LED_OFF);
 }
+
+/**
+ * @brief Set every LED of the array in one GPIO write
+ * @param mask bit i lights LED i
+ */
+void led_write_mask(uint8_t mask)
+{
+    gpio_put_masked(LED_BANK_MASK, (uint32_t)mask << LED_PIN_BASE);
+}
+
+/**
+ * @brief Set the brightness of every LED (PWM mode)
+ *
+ * Pins come in A/B pairs of one slice, so this is one counter-compare
+ * write per slice
+ *
+ * @param levels per LED, 0 (off) to LED_PWM_LEVELS (always on)
+ */
+void led_write_levels(const uint16_t levels[NUM_LEDS])
+{
+    for (uint8_t i = 0; i < NUM_LEDS; i += 2)
+    {
+        pwm_set_both_levels(pwm_gpio_to_slice_num(leds[i]), levels[i], levels[i + 1]);
+    }
+}
+
+/**
+ * @brief Switch the array pins between plain outputs and PWM
+ *
+ * Every LED is off after the switch
+ *
+ * @param enable true for PWM levels, false for on/off
+ */
+void led_set_pwm(bool enable)
+{
+    for (uint8_t i = 0; i < NUM_LEDS; i += 2)
+    {
+        uint slice = pwm_gpio_to_slice_num(leds[i]);
+
+        if (enable)
+        {
+            pwm_config c = pwm_get_default_config();
+            pwm_config_set_wrap(&c, LED_PWM_LEVELS - 1);
+            pwm_init(slice, &c, false);
+            pwm_set_both_levels(slice, 0, 0);
+            pwm_set_enabled(slice, true);
+        }
+        else
+        {
+            pwm_set_enabled(slice, false);
+        }
+    }
+
+    led_write_mask(0);
+    for (uint8_t i = 0; i < NUM_LEDS; i++)
+    {
+        gpio_set_function(leds[i], enable ? GPIO_FUNC_PWM : GPIO_FUNC_SIO);
+    }
+    pwm_mode = enable;
+}
+
+bool led_pwm_enabled(void)
+{
+    return pwm_mode;
+}
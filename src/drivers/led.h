@@ -2,6 +2,10 @@
  * @file led.h
  * @brief led driver for 6 stage led_array
  *
+ * The LEDs sit on consecutive pins, so the array is written as one bank:
+ * bit i of a mask drives LED i. In PWM mode each LED takes a level
+ * instead (0 off, LED_PWM_LEVELS fully on); GPIO 10-15 are PWM slices
+ * 5-7, channels A and B.
  */
 
 #include "pico/stdlib.h"
@@ -9,9 +13,18 @@
 extern const uint8_t leds[];
 
 #define NUM_LEDS 6
+#define LED_PIN_BASE 10
+#define LED_BANK_MASK (((1u << NUM_LEDS) - 1) << LED_PIN_BASE)
 #define LED_ON 1
 #define LED_OFF 0
 
+// PWM counter wraps after this many counts: 62.5 kHz at 125 MHz
+#define LED_PWM_LEVELS 2000
+
 void led_init();
 void led_off(uint8_t led_pin);
 void led_on(uint8_t led_pin);
+void led_write_mask(uint8_t mask);
+void led_write_levels(const uint16_t levels[NUM_LEDS]);
+void led_set_pwm(bool enable);
+bool led_pwm_enabled(void);
@@ -2,7 +2,10 @@
  * @file led_strip.c
  * @brief WS2812B RGB LED strip driver using Pico PIO
  *
- * Controls 8x WS2812B addressable LEDs (GP2) to visualize temperature
+ * Drives one strip on GP2 (ws2812 program) or 2 to 8 equal-length strips
+ * in parallel from one state machine on GP16 upwards (ws2812_parallel
+ * program), e.g. one wall-mounted strip per room zone. Strip count and
+ * length are set at runtime with led_strip_configure().
  *
  * Hardware:
  * - WS2812B Datasheet: https://cdn-shop.adafruit.com/datasheets/WS2812B.pdf
@@ -10,6 +13,17 @@
  * - GPIO 2 (data in), 5V power (external supply recommended for >8 LEDs)
  * EXTERNAL 5V POWER REQUIRED
  * USB cannot reliably power >3 WS2812 LEDs. Use external 5V supply for 8-LED strip.
+ *
+ * Frames are sent by DMA into the PIO TX FIFO from two buffers: one is
+ * on the wire (front), the next frame is staged in the other (back). The
+ * DMA completion IRQ arms an alarm that covers the FIFO drain plus the
+ * reset latch; only after it fires may the next frame start, so frames
+ * staged meanwhile coalesce into the newest one.
+ *
+ * The parallel program takes one 32-bit word per bit time, bit n driving
+ * strip n, so a pixel index becomes 24 bit-plane words. They are built
+ * with an 8x8 bit-matrix transpose per color byte rather than a loop over
+ * single bits.
  */
 
 #include <stdio.h>
@@ -17,84 +31,401 @@
 
 #include "pico/stdlib.h"
 #include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
 #include "hardware/clocks.h"
 #include "ws2812.pio.h"
 #include "led_strip.h"
 
 
-#define WS2812_PIN 2
-#define NUM_STRIP_LEDS 8
+#define WS2812_PIN 2                // single strip
+#define WS2812_PARALLEL_PIN_BASE 16 // parallel strips: GP16 + strip index
 #define IS_RGBW false
+#define BITS_PER_PIXEL 24
+#define FRAME_WORDS (LED_STRIP_MAX_PIXELS * BITS_PER_PIXEL)
 
+// When the DMA completion IRQ fires, the joined 8-entry FIFO can still
+// hold 8 words and the OSR is shifting a 9th: 9 pixels (30 us each at
+// 800 kHz) in single mode, 9 bit times in parallel mode. Then the line
+// must stay low for the reset latch (>= 280 us on current WS2812B parts).
+#define WS2812_FIFO_DRAIN_US ((8 + 1) * 30)
+#define WS2812_PARALLEL_FIFO_DRAIN_US ((8 + 1) * 2)  // 1.25 us bits, rounded up
+#define WS2812_RESET_US 280
 
-static uint32_t led_strip_array[NUM_STRIP_LEDS];
+
+// Pixels per strip in 0xGGRRBB format
+static uint32_t led_strip_array[LED_STRIP_MAX_STRIPS][LED_STRIP_MAX_PIXELS];
+static uint8_t num_strips = 1;
+static uint16_t strip_length = LED_STRIP_DEFAULT_LENGTH;
 
 // Private global variabples for PIO state
 static PIO pio;
 static uint sm;
 static uint offset;
+static const pio_program_t* program = NULL;
+
+// DMA double buffer in the state machine's wire format: pixels shifted
+// into the 24-bit MSB position, or bit-plane words for parallel strips
+static uint32_t frames[2][FRAME_WORDS];
+static uint32_t frame_words = 0;        // words per frame for the current layout
+static uint32_t latch_us = WS2812_FIFO_DRAIN_US + WS2812_RESET_US;
+static volatile uint8_t front = 0;      // frame on the wire, or last sent
+static volatile bool busy = false;      // DMA or reset latch in progress
+static volatile bool pending = false;   // back buffer holds a frame to send
+static int dma_chan = -1;
+static led_strip_stats_t stats;
 
 
 /**
- * @brief Initialize WS2812B LED strip PIO state machine
- * 
- * Claims free PIO block and state machine, loads WS2812 program,
- * configures for 800kHz pixel clock on GPIO 2.
- * 
- * @note Must be called once before any led_pattern_*() functions
- * @warning Fails hard with hard_assert() if no PIO resources available
+ * @brief swap buffers and start sending the back buffer
+ * @note Called with interrupts disabled or from IRQ context
  */
-void led_strip_init(void) {
+static void start_frame(void) {
+        front ^= 1;
+        pending = false;
+        busy = true;
+        stats.frames_sent++;
+        dma_channel_transfer_from_buffer_now((uint)dma_chan, frames[front], frame_words);
+}
+
+/**
+ * @brief reset latch elapsed: the strip has shown the frame
+ * @return 0 so the alarm is not rescheduled
+ */
+static int64_t latch_done_callback(alarm_id_t id, void* user_data) {
+        busy = false;
+        if (pending) {
+                start_frame();
+        }
+        return 0;
+}
+
+/**
+ * @brief DMA completion IRQ: the last word is in the FIFO, time the latch
+ */
+static void dma_complete_handler(void) {
+        if (dma_chan < 0 || !dma_channel_get_irq0_status((uint)dma_chan)) {
+                return; // shared handler: another channel's IRQ
+        }
+        dma_channel_acknowledge_irq0((uint)dma_chan);
+        if (add_alarm_in_us(latch_us, latch_done_callback, NULL, true) <= 0) {
+                // no free alarm slot: wait out the latch here (at most
+                // about 0.6 ms) rather than leave the strip busy for good
+                stats.latch_alarm_failures++;
+                busy_wait_us(latch_us);
+                latch_done_callback(0, NULL);
+        }
+}
+
+/**
+ * @brief Transpose an 8x8 bit matrix held as two words of four rows each
+ *
+ * Row r is byte (3 - r % 4) of hi (rows 0-3) or lo (rows 4-7), bit 7 is
+ * column 0. On return row c holds what was column c. Three rounds swap
+ * 1x1, 2x2 and 4x4 blocks across the diagonal (Hacker's Delight 7-3).
+ */
+static inline void transpose8(uint32_t* hi, uint32_t* lo) {
+        uint32_t x = *hi;
+        uint32_t y = *lo;
+        uint32_t t;
+
+        t = (x ^ (x >> 7)) & 0x00AA00AAu;
+        x = x ^ t ^ (t << 7);
+        t = (y ^ (y >> 7)) & 0x00AA00AAu;
+        y = y ^ t ^ (t << 7);
+
+        t = (x ^ (x >> 14)) & 0x0000CCCCu;
+        x = x ^ t ^ (t << 14);
+        t = (y ^ (y >> 14)) & 0x0000CCCCu;
+        y = y ^ t ^ (t << 14);
+
+        t = (x & 0xF0F0F0F0u) | ((y >> 4) & 0x0F0F0F0Fu);
+        y = ((x << 4) & 0xF0F0F0F0u) | (y & 0x0F0F0F0Fu);
+
+        *hi = t;
+        *lo = y;
+}
+
+/**
+ * @brief Build the 24 bit-plane words of one pixel index across all strips
+ *
+ * Word k holds bit (23 - k) of every strip's GRB value, strip n in bit n,
+ * which is the order ws2812_parallel shifts them out
+ *
+ * @param index pixel index along the strips
+ * @param out 24 words
+ */
+static void pixel_to_planes(uint16_t index, uint32_t* out) {
+        // strip 7 goes in row 0 so that, after the transpose, strip n
+        // lands in bit n of each output byte
+        uint32_t px[8] = {0};
+        for (uint8_t s = 0; s < num_strips; s++) {
+                px[7 - s] = led_strip_array[s][index];
+        }
+
+        for (uint8_t byte = 0; byte < 3; byte++) {
+                uint8_t shift = (uint8_t)(16 - 8 * byte);   // G, R, then B
+                uint32_t hi = ((px[0] >> shift & 0xFF) << 24) | ((px[1] >> shift & 0xFF) << 16) |
+                              ((px[2] >> shift & 0xFF) << 8) | (px[3] >> shift & 0xFF);
+                uint32_t lo = ((px[4] >> shift & 0xFF) << 24) | ((px[5] >> shift & 0xFF) << 16) |
+                              ((px[6] >> shift & 0xFF) << 8) | (px[7] >> shift & 0xFF);
+
+                transpose8(&hi, &lo);
+
+                uint32_t* w = &out[8 * byte];
+                w[0] = hi >> 24;
+                w[1] = (hi >> 16) & 0xFF;
+                w[2] = (hi >> 8) & 0xFF;
+                w[3] = hi & 0xFF;
+                w[4] = lo >> 24;
+                w[5] = (lo >> 16) & 0xFF;
+                w[6] = (lo >> 8) & 0xFF;
+                w[7] = lo & 0xFF;
+        }
+}
+
+/**
+ * @brief Load the PIO program for a strip count and point the DMA at it
+ * @return false if no PIO state machine is free
+ */
+static bool claim_program(uint8_t strips) {
+        bool parallel = strips > 1;
+        uint pin = parallel ? WS2812_PARALLEL_PIN_BASE : WS2812_PIN;
+        const pio_program_t* prog = parallel ? &ws2812_parallel_program : &ws2812_program;
+
         // This will find a free pio and state machine for our program and load it for us
         // We use pio_claim_free_sm_and_add_program_for_gpio_range (for_gpio_range variant)
         // so we will get a PIO instance suitable for addressing gpios >= 32 if needed and supported by the hardware
-        bool success = pio_claim_free_sm_and_add_program_for_gpio_range(&ws2812_program, &pio, &sm, &offset, WS2812_PIN, 1, true);
-        if (!success) {
+        if (!pio_claim_free_sm_and_add_program_for_gpio_range(prog, &pio, &sm, &offset, pin, strips, true)) {
                 printf("ERROR: Failed to clain PIO for WS2812\n");
+                program = NULL;
+                return false;
+        }
+        program = prog;
+
+        if (parallel) {
+                ws2812_parallel_program_init(pio, sm, offset, pin, strips, 800000);
+                latch_us = WS2812_PARALLEL_FIFO_DRAIN_US + WS2812_RESET_US;
+        } else {
+                ws2812_program_init(pio, sm, offset, pin, 800000, IS_RGBW);
+                latch_us = WS2812_FIFO_DRAIN_US + WS2812_RESET_US;
+        }
+
+        dma_channel_config c = dma_channel_get_default_config((uint)dma_chan);
+        channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+        channel_config_set_read_increment(&c, true);
+        channel_config_set_write_increment(&c, false);
+        channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+        dma_channel_configure((uint)dma_chan, &c, &pio->txf[sm], NULL, 0, false);
+        return true;
+}
+
+/**
+ * @brief Stop driving the current strips and free their state machine
+ */
+static void release_program(void) {
+        if (program == NULL) {
                 return;
         }
-        ws2812_program_init(pio, sm, offset, WS2812_PIN, 800000, IS_RGBW);
+        uint pin = (num_strips > 1) ? WS2812_PARALLEL_PIN_BASE : WS2812_PIN;
+
+        pio_sm_set_enabled(pio, sm, false);
+        pio_remove_program_and_unclaim_sm(program, pio, sm, offset);
+        for (uint8_t i = 0; i < num_strips; i++) {
+                gpio_init(pin + i);     // back to a plain input
+        }
+        program = NULL;
+}
+
+/**
+ * @brief Initialize WS2812B LED strip PIO state machine and DMA channel
+ *
+ * Claims free PIO block and state machine, loads WS2812 program,
+ * configures for 800kHz pixel clock on GPIO 2 with one strip of
+ * LED_STRIP_DEFAULT_LENGTH pixels.
+ *
+ * @note Must be called once before any led_pattern_*() functions
+ * @warning Fails hard with hard_assert() if no DMA channel is available
+ */
+void led_strip_init(void) {
+        dma_chan = dma_claim_unused_channel(true);
+        dma_channel_set_irq0_enabled((uint)dma_chan, true);
+        irq_add_shared_handler(DMA_IRQ_0, dma_complete_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+        irq_set_enabled(DMA_IRQ_0, true);
+
+        led_strip_configure(1, LED_STRIP_DEFAULT_LENGTH);
+}
+
+/**
+ * @brief Change the number of strips and their length
+ *
+ * Waits for the frame on the wire to finish, switches between the single
+ * and parallel programs, and clears all pixels. The next led_strip_light()
+ * sends a full frame.
+ *
+ * @param strips 1 (GPIO 2) or 2 to LED_STRIP_MAX_STRIPS (GPIO 16 upwards)
+ * @param length pixels per strip, 1 to LED_STRIP_MAX_PIXELS
+ * @return false if the layout is out of range or no state machine is free
+ */
+bool led_strip_configure(uint8_t strips, uint16_t length) {
+        if (dma_chan < 0 || strips == 0 || strips > LED_STRIP_MAX_STRIPS ||
+            length == 0 || length > LED_STRIP_MAX_PIXELS) {
+                return false;
+        }
+
+        // the longest frame plus latch is about 10 ms (300 px single)
+        absolute_time_t deadline = make_timeout_time_ms(50);
+        while ((busy || pending) && absolute_time_diff_us(get_absolute_time(), deadline) > 0) {
+                tight_loop_contents();
+        }
+        uint32_t irq = save_and_disable_interrupts();
+        pending = false;
+        restore_interrupts(irq);
+
+        // abort can raise a spurious completion IRQ (RP2040-E13)
+        dma_channel_set_irq0_enabled((uint)dma_chan, false);
+        dma_channel_abort((uint)dma_chan);
+        dma_channel_acknowledge_irq0((uint)dma_chan);
+        dma_channel_set_irq0_enabled((uint)dma_chan, true);
+        busy = false;
+
+        if (program == NULL || strips != num_strips) {
+                release_program();
+                num_strips = strips;
+                if (!claim_program(strips)) {
+                        return false;
+                }
+        }
+        num_strips = strips;
+        strip_length = length;
+        frame_words = (strips > 1) ? (uint32_t)length * BITS_PER_PIXEL : length;
+
+        // the strips power up in an unknown state; make sure the first
+        // frame is sent even if it is all black
+        for (uint32_t i = 0; i < frame_words; i++) {
+                frames[front][i] = 0xFFFFFFFFu;
+        }
         led_strip_array_clear();
+        return true;
+}
+
+/**
+ * @brief Number of strips driven
+ */
+uint8_t led_strip_count(void) {
+        return num_strips;
 }
 
 /**
- * @brief Sets ALL 'LEDs' in our led_strip_array with the desired color
+ * @brief Pixels per strip
+ */
+uint16_t led_strip_length(void) {
+        return strip_length;
+}
+
+/**
+ * @brief Set one pixel of one strip
+ * @param strip strip index (room zone)
+ * @param index pixel index along the strip
  * @param color 32-bit GRB color value (0xGGRRBB format)
  */
-void led_strip_array_fill(uint32_t color) {
-        for (uint8_t i = 0; i < NUM_STRIP_LEDS; i++) {
-                led_strip_array[i] = color;
+void led_strip_set_pixel(uint8_t strip, uint16_t index, uint32_t color) {
+        if (strip < num_strips && index < strip_length) {
+                led_strip_array[strip][index] = color;
         }
 }
 
 /**
- * @brief Sets partial 'LEDs' in our led_strip_array with the desired color
+ * @brief Sets ALL 'LEDs' of every strip with the desired color
+ * @param color 32-bit GRB color value (0xGGRRBB format)
+ */
+void led_strip_array_fill(uint32_t color) {
+        led_strip_array_fill_partial(strip_length, color);
+}
+
+/**
+ * @brief Sets the first pixels of every strip with the desired color
+ * @param num_leds_to_fill pixels to set from the start of each strip
  * @param color 32-bit GRB color value (0xGGRRBB format)
  */
-void led_strip_array_fill_partial(uint8_t num_leds_to_fill, uint32_t color) {
-        if (num_leds_to_fill > NUM_STRIP_LEDS) {
-                num_leds_to_fill = NUM_STRIP_LEDS;
+void led_strip_array_fill_partial(uint16_t num_leds_to_fill, uint32_t color) {
+        if (num_leds_to_fill > strip_length) {
+                num_leds_to_fill = strip_length;
         }
-        for (uint8_t i = 0; i < num_leds_to_fill; i++) {
-                led_strip_array[i] = color;
+        for (uint8_t s = 0; s < num_strips; s++) {
+                for (uint16_t i = 0; i < num_leds_to_fill; i++) {
+                        led_strip_array[s][i] = color;
+                }
         }
 }
 
 /**
  * @brief Clear led_strip_array (all LEDs off)
- * Sets entire array to black (0x000000). 
+ * Sets entire array to black (0x000000).
  */
 void led_strip_array_clear(void) {
         led_strip_array_fill(0); // sets all leds in the array to black (i.e. black == OFF)
 }
 
 /**
- * @brief Transmit the colors in led_strip_array to WS2812 hardware via PIO
- * Each 32-bit color value is shifted left 8 bits (<< 8u).
+ * @brief Queue the colors in led_strip_array for the WS2812 strips
+ *
+ * Converts the pixels into the back buffer (each color shifted left 8
+ * bits, or transposed into bit planes for parallel strips) and returns
+ * without waiting: the DMA starts now if the strips are idle, or from the
+ * latch alarm once the current frame has been shown. A frame identical
+ * to the one last sent is not retransmitted.
  */
 void led_strip_light(void) {
-        // Stream buffer to PIO
-        for (uint8_t i = 0; i < NUM_STRIP_LEDS; i++) {
-                pio_sm_put_blocking(pio, sm, led_strip_array[i] << 8u);
+        if (dma_chan < 0 || program == NULL) {
+                return; // init failed
+        }
+
+        // a long frame takes too long to build with interrupts off; hold
+        // back any staged frame so the latch alarm cannot start the back
+        // buffer while it is being rewritten
+        uint32_t irq = save_and_disable_interrupts();
+        bool was_pending = pending;
+        pending = false;
+        restore_interrupts(irq);
+
+        uint32_t* back = frames[front ^ 1];
+        if (num_strips > 1) {
+                for (uint16_t i = 0; i < strip_length; i++) {
+                        pixel_to_planes(i, &back[i * BITS_PER_PIXEL]);
+                }
+        } else {
+                for (uint16_t i = 0; i < strip_length; i++) {
+                        back[i] = led_strip_array[0][i] << 8u;
+                }
         }
-}
\ No newline at end of file
+
+        irq = save_and_disable_interrupts();
+        // front can only change while pending, so it is stable here
+        const uint32_t* shown = frames[front];
+        bool changed = false;
+        for (uint32_t i = 0; i < frame_words && !changed; i++) {
+                changed = (back[i] != shown[i]);
+        }
+
+        if (!changed) {
+                // also drops a staged frame that has been changed back
+                stats.frames_skipped++;
+        } else if (busy) {
+                if (was_pending) {
+                        stats.frames_coalesced++;
+                }
+                pending = true;
+        } else {
+                start_frame();
+        }
+        restore_interrupts(irq);
+}
+
+/**
+ * @brief Frame counters: sent, skipped as unchanged, replaced before sending
+ */
+const led_strip_stats_t* led_strip_get_stats(void) {
+        return &stats;
+}
@@ -9,9 +9,29 @@
 
 #pragma once
 
+#include <stdbool.h>
+#include <stdint.h>
+
+// Strips on GP16 upwards are driven in parallel, one per room zone. The
+// pixel and DMA buffers are sized for the maximum layout: about 67 KB.
+#define LED_STRIP_MAX_STRIPS 8
+#define LED_STRIP_MAX_PIXELS 300
+#define LED_STRIP_DEFAULT_LENGTH 8
+
+typedef struct {
+        uint32_t frames_sent;       // frames handed to DMA
+        uint32_t frames_skipped;    // identical to the frame on the strip
+        uint32_t frames_coalesced;  // replaced by a newer frame before sending
+        uint32_t latch_alarm_failures;  // latch timed by busy-wait, no alarm free
+} led_strip_stats_t;
 
 void led_strip_init(void);
+bool led_strip_configure(uint8_t strips, uint16_t length);
+uint8_t led_strip_count(void);
+uint16_t led_strip_length(void);
+void led_strip_set_pixel(uint8_t strip, uint16_t index, uint32_t color);
 void led_strip_array_fill(uint32_t color);
-void led_strip_array_fill_partial(uint8_t num_leds_to_fill, uint32_t color);
+void led_strip_array_fill_partial(uint16_t num_leds_to_fill, uint32_t color);
 void led_strip_array_clear(void);
-void led_strip_light(void);
\ No newline at end of file
+void led_strip_light(void);
+const led_strip_stats_t* led_strip_get_stats(void);
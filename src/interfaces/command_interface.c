@@ -5,143 +5,262 @@
 
 #include "command_interface.h"
 #include "parse.h"
+#include "telemetry.h"
+#include "../app/events.h"
 
-// Command table
-static const cmd_entry_t* command_table[MAX_COMMANDS];
-static uint8_t command_count = 0;
+#define CMD_RX_RING_MASK (CMD_RX_RING_SIZE - 1)
 
-// Builtin help handler
-void help_handler(const int32_t* args);
-static cmd_entry_t help_command = {
-    .name = "help",
-    .handler = help_handler,
-    .num_args = 0,
-};
+_Static_assert((CMD_RX_RING_SIZE & CMD_RX_RING_MASK) == 0,
+               "CMD_RX_RING_SIZE must be a power of two");
+
+// RX ring: raw USB input not yet assembled into lines
+static char rx_ring[CMD_RX_RING_SIZE];
+static uint16_t rx_head = 0;
+static uint16_t rx_tail = 0;
+
+// Line assembler state, kept across calls so split packets join up
+static char cmd_line[CMD_BUFFER_SIZE];
+static uint8_t cmd_line_pos = 0;
+static bool cmd_line_overflow = false;
+
+/**
+ * @brief find a command in the sorted table
+ *
+ * Binary search keeps lookup at O(log n) string compares as the table grows
+ *
+ * @param name the command name
+ *
+ * @return the command entry, or NULL if unknown
+ */
+static const cmd_entry_t* cmd_lookup(const char* name)
+{
+    size_t low = 0;
+    size_t high = command_table_size;
+
+    while (low < high)
+    {
+        size_t mid = low + (high - low) / 2;
+        int order = strcmp(name, command_table[mid].name);
+
+        if (order == 0)
+            return &command_table[mid];
+        if (order < 0)
+            high = mid;
+        else
+            low = mid + 1;
+    }
+    return NULL;
+}
 
 /**
- * @brief execute a command from the command interface
+ * @brief validate the arguments of a command and run it
  *
- * function will check the number of arguments with the value
- * listed in the command table, and send an error message if
- * the numbers don't match
+ * Each argument is validated and converted against the command's schema
+ * while the rest of the line is tokenized, so the line is walked only once
  *
- * @param cmd the command to execute
- * @param args pointer to the arguments for the command
- * @param num_args number of arguments for the command
+ * @param name the command name
+ * @param cursor the rest of the command line, modified in place
+ *
+ * @return true if the command was run
  */
-static void cmd_execute(parsed_cmd_t* parsed_cmd)
+static bool cmd_dispatch(const char* name, char* cursor)
 {
-    // search command table for a match
-    for (uint8_t i = 0; i < command_count; i++) 
+    const cmd_entry_t* cmd = cmd_lookup(name);
+    if (cmd == NULL)
     {
-        if (strcmp(parsed_cmd->cmd, command_table[i]->name) == 0) 
+        // Unknown command
+        printf("\nERROR: Unknown command '%s'. Type 'help' for available commands.\n", 
+               name);
+        return false;
+    }
+
+    cmd_arg_t args[CMD_MAX_ARGS];
+    uint8_t num_args = 0;
+    const char* token;
+
+    bool too_many = false;
+
+    while ((token = parse_token(&cursor)) != NULL)
+    {
+        if (num_args >= cmd->num_args)
         {
-            // Validate argument count
-            if (parsed_cmd->num_args != command_table[i]->num_args) 
-            {
-                printf("\nERROR: Command '%s' expects %d arguments, got %d\n",
-                       command_table[i]->name,
-                       command_table[i]->num_args,
-                       parsed_cmd->num_args);
-                return;
-            }
-            
-            // Execute command
-            command_table[i]->handler(parsed_cmd->args);
-            return;
+            too_many = true;
+            break;
         }
+        if (!parse_arg(token, &cmd->args[num_args], &args[num_args]))
+        {
+            return false;
+        }
+        num_args++;
+    }
+
+    // Validate argument count
+    uint8_t required = cmd->num_args - cmd->optional_args;
+    if (too_many || num_args < required)
+    {
+        if (cmd->optional_args > 0)
+            printf("\nERROR: Command '%s' expects %d to %d arguments\n",
+                   cmd->name, required, cmd->num_args);
+        else
+            printf("\nERROR: Command '%s' expects %d arguments\n",
+                   cmd->name, cmd->num_args);
+        return false;
     }
-    
-    // Unknown command
-    printf("\nERROR: Unknown command '%s'. Type 'help' for available commands.\n", 
-           parsed_cmd->cmd);
+
+    // Execute command
+    cmd->handler(args, num_args);
+    return true;
 }
 
+/**
+ * @brief parse and execute a command line
+ *
+ * In binary telemetry mode every command is answered with an ACK frame
+ *
+ * @param line the command line, modified in place
+ */
+static void cmd_execute(char* line)
+{
+    char* cursor = line;
+    const char* name = parse_token(&cursor);
+
+    if (name == NULL)
+    {
+        return;
+    }
+
+    bool ok = cmd_dispatch(name, cursor);
+    telemetry_send_ack(name, ok);
+}
 
 /**
- * @brief init the command table with the help command
+ * @brief stdio callback: new characters arrived on USB
  */
-void cmd_init(void)
+static void usb_rx_callback(void* param)
 {
-    // register built in help command
-    cmd_register(&help_command);
+    event_post(EVENT_USB_RX);
 }
 
 /**
- * @brief register a new command onto the command table
+ * @brief check the static command table and hook USB input
  *
- * @param command the command entry to add to the tabl 
+ * Arriving characters post EVENT_USB_RX
  */
-void cmd_register(const cmd_entry_t* command)
+void cmd_init(void)
 {
-    if (command_count >= MAX_COMMANDS) {
-        printf("\nERROR: Command table full\n");
-        return;
+    // binary search relies on the table being sorted
+    for (size_t i = 1; i < command_table_size; i++)
+    {
+        if (strcmp(command_table[i - 1].name, command_table[i].name) >= 0)
+        {
+            printf("\nERROR: Command table not sorted at '%s'\n", command_table[i].name);
+        }
     }
-    
-    command_table[command_count++] = command;
-}
 
+    stdio_set_chars_available_callback(usb_rx_callback, NULL);
+}
 
 /**
- * @brief process the command string from the usb port
+ * @brief move all pending USB input into the RX ring
  *
- * Utilizes the parse module to parse the command string
- * into a command and its arguments. 
+ * @return true if the ring filled up before the input ran out
  */
-void cmd_process(void)
+static bool rx_fill(void)
 {
-    uint8_t chars_processed = 0;
-    char cmd_line[CMD_BUFFER_SIZE];
-    uint8_t cmd_line_pos = 0;
-    
-    // read pipe up to max characters
-    while (chars_processed < CMD_BUFFER_SIZE) 
+    while ((uint16_t)(rx_head - rx_tail) < CMD_RX_RING_SIZE)
     {
         int c = getchar_timeout_us(0);
-        
+
         // No data
         if (c == PICO_ERROR_TIMEOUT) {
-            return; 
+            return false;
         }
-        
-        chars_processed++;
-        
+
+        rx_ring[rx_head++ & CMD_RX_RING_MASK] = (char)c;
+    }
+    return true;
+}
+
+/**
+ * @brief parse and execute the assembled line, then reset the assembler
+ */
+static void run_line(void)
+{
+    if (cmd_line_overflow)
+    {
+        printf("ERROR: Command too long, max %d characters\n", CMD_BUFFER_SIZE - 1);
+    }
+    else if (cmd_line_pos > 0) // skip empty lines (e.g. from "\r\n")
+    {
+        cmd_line[cmd_line_pos] = '\0';
+        cmd_execute(cmd_line);
+    }
+
+    cmd_line_pos = 0;
+    cmd_line_overflow = false;
+}
+
+/**
+ * @brief process the command strings from the usb port
+ *
+ * Drains all pending input into a persistent RX ring, then assembles
+ * and executes every complete line. A partial line stays in the
+ * assembler until the rest of it arrives. At most
+ * CMD_MAX_LINES_PER_PASS lines run per call so other tasks keep their
+ * deadlines under a long pipelined batch.
+ *
+ * Utilizes the parse module to parse the command string
+ * into a command and its arguments. 
+ *
+ * @return true if processing stopped with input possibly still pending
+ */
+bool cmd_process(void)
+{
+    bool more_input = rx_fill();
+    uint8_t lines = 0;
+
+    while (rx_tail != rx_head)
+    {
+        char c = rx_ring[rx_tail++ & CMD_RX_RING_MASK];
+
         // process and execute command on newline/return
-        if (c == '\n' || c == '\r') 
+        if (c == '\n' || c == '\r')
         {
-            cmd_line[cmd_line_pos++] = '\0';
-
-            parsed_cmd_t parsed_cmd;
-            if (parse_line(cmd_line, &parsed_cmd))
+            run_line();
+            if (++lines >= CMD_MAX_LINES_PER_PASS)
             {
-                cmd_execute(&parsed_cmd);
+                return true;
             }
-            return;
         }
-
-        cmd_line[cmd_line_pos++] = c;
+        else if (cmd_line_pos < CMD_BUFFER_SIZE - 1)
+        {
+            cmd_line[cmd_line_pos++] = c;
+        }
+        else
+        {
+            cmd_line_overflow = true; // discard until end of line
+        }
     }
 
-    if (chars_processed >= CMD_BUFFER_SIZE)
-    {
-        printf("ERROR: Command too long, max %d characters\n", CMD_BUFFER_SIZE - 1);
-    }
+    return more_input;
 }
 
 /**
  * @brief built in help function to list available commands
  *
  */
-void help_handler(const int32_t* args)
+void cmd_help(const cmd_arg_t* args, uint8_t num_args)
 {
-    printf("\nRegistered Commands (%d):\n", command_count);
-    for (uint8_t i = 0; i < command_count; i++) {
-        printf("  %d. %s (%d args)\n", 
-               i + 1, 
-               command_table[i]->name,
-               command_table[i]->num_args);
+    printf("\nRegistered Commands (%d):\n", (int)command_table_size);
+    for (size_t i = 0; i < command_table_size; i++) {
+        const cmd_entry_t* cmd = &command_table[i];
+        uint8_t required = cmd->num_args - cmd->optional_args;
+
+        printf("  %d. %s", (int)(i + 1), cmd->name);
+        for (uint8_t a = 0; a < cmd->num_args; a++) {
+            printf(a < required ? " <%s>" : " [%s]", cmd->args[a].name);
+        }
+        printf("\n");
     }
     printf("\n");
 }
-
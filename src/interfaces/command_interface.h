@@ -1,22 +1,33 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
+#include "parse.h"
 
 // Maximum number of arguments for a command
 #define CMD_BUFFER_SIZE 128
-#define MAX_COMMANDS 32
+#define CMD_RX_RING_SIZE 256        // must be a power of two
+#define CMD_MAX_LINES_PER_PASS 16   // commands executed per cmd_process() call
 
 // Command handler function type
-typedef void (*cmd_handler_t)(const int32_t* args);
+// args holds num_args converted values, in schema order
+typedef void (*cmd_handler_t)(const cmd_arg_t* args, uint8_t num_args);
 
 // Command table entry
 typedef struct {
-    const char* name;           // Command name (e.g., "mock_temp")
+    const char* name;           // Command name (e.g., "temp")
     cmd_handler_t handler;      // Function to call
-    uint8_t num_args;      // Number of arguments expected
+    uint8_t num_args;           // Number of arguments declared in args
+    uint8_t optional_args;      // How many trailing args may be omitted
+    cmd_arg_spec_t args[CMD_MAX_ARGS];  // Per-argument schema
 } cmd_entry_t;
 
+// Static command registry, defined in commands.c
+// Must be sorted by name (strcmp order); cmd_init() verifies this
+extern const cmd_entry_t command_table[];
+extern const size_t command_table_size;
+
 void cmd_init(void);
-void cmd_process(void);
-void cmd_register(const cmd_entry_t* command);
+bool cmd_process(void);
+void cmd_help(const cmd_arg_t* args, uint8_t num_args);
@@ -2,67 +2,651 @@
 #include "command_interface.h"
 #include "../app/sensor_task.h"
 #include "../app/ui.h"
+#include "../app/fixed_point.h"
+#include "../app/events.h"
+#include "../app/scheduler.h"
+#include "../app/sample_history.h"
+#include "../app/flash_store.h"
+#include "../app/rrd.h"
+#include "../app/rolling_stats.h"
+#include "../app/sample_filter.h"
+#include "../app/psychro.h"
+#include "../app/alarm.h"
+#include "../app/led_anim.h"
+#include "../drivers/dht20.h"
+#include "../drivers/led_strip.h"
+#include "telemetry.h"
+#include "usb_tx.h"
 
-static void mock_temp(const int32_t args[])
+// Enum argument choices
+static const char* const unit_choices[] = {"C", "F", NULL};
+static const char* const on_off_choices[] = {"off", "on", NULL};
+static const char* const mode_choices[] = {"text", "binary", NULL};
+static const char* const flash_choices[] = {"info", "flush", "dump", NULL};
+static const char* const tier_choices[] = {"raw", "minute", "hour", NULL};
+static const char* const stats_choices[] = {"show", "reset", NULL};
+static const char* const filter_choices[] = {"show", "reset", NULL};
+static const char* const lcd_field_choices[] = {"temp", "humid", "dew", "heat", "abs", NULL};
+static const char* const field_choices[] = {"dew", "heat", "abs", NULL};
+static const char* const alarm_choices[] = {"list", "delete", "events", NULL};
+static const char* const alarm_channel_choices[] = {"temp", "humid", "dew", "heat", NULL};
+static const char* const alarm_kind_choices[] = {"high", "low", "rise", "fall", NULL};
+static const char* const view_choices[] = {"raw", "smooth", NULL};
+static const char* const alarm_effect_choices[] = {"solid", "pulse", "blink", NULL};
+static const char* const array_choices[] = {"step", "pwm", NULL};
+
+static void mock_temp(const cmd_arg_t args[], uint8_t num_args)
 {
-    float temp = (float)args[0];
-    temp += ((float)args[1] / 10);
-    
+    int32_t temp = args[0].centi;
+    char text[12];
+
     set_mock_temp(temp);
     set_mock_sensor(true);
     
-    printf("OK: Mock temperature set to %.1f°C\n", temp);
+    fixed_format_tenths(text, sizeof(text), temp);
+    printf("OK: Mock temperature set to %s°C\n", text);
 }
 
-static void mock_humid(const int32_t args[])
+static void mock_humid(const cmd_arg_t args[], uint8_t num_args)
 {
-    float humidity = (float)args[0];
-    humidity += ((float)args[1] / 10);
+    int32_t humidity = args[0].centi;
+    char text[12];
 
     set_mock_humid(humidity);
     set_mock_sensor(true);
     
-    printf("OK: Mock humidity set to %.0f%%\n", humidity);
+    fixed_format_tenths(text, sizeof(text), humidity);
+    printf("OK: Mock humidity set to %s%%\n", text);
 }
 
-static void mock_sens(const int32_t args[])
+static void mock_sens(const cmd_arg_t args[], uint8_t num_args)
 {
-    set_mock_sensor(args[0]);
+    set_mock_sensor(args[0].choice);
     
-    const char* status = args[0] ? "enabled" : "disabled";
+    const char* status = args[0].choice ? "enabled" : "disabled";
     printf("OK: Mock mode %s\n", status);
 }
 
-static void set_unit(const int32_t args[])
+static void set_unit(const cmd_arg_t args[], uint8_t num_args)
 {
-    set_temp_unit(args[0]);
+    set_temp_unit(args[0].choice);
     
-    printf("OK: unit set");
+    printf("OK: unit set to %s\n", unit_choices[args[0].choice]);
+}
+
+static void set_pattern(const cmd_arg_t args[], uint8_t num_args) 
+{
+    set_led_strip_pattern((uint8_t)args[0].i);
+    printf("LED strip pattern set to %ld\n", (long)args[0].i);
+}
+
+static void set_array_mode(const cmd_arg_t args[], uint8_t num_args)
+{
+    set_led_array_pwm(args[0].choice == 1);
+    printf("OK: humidity LEDs in %s mode\n", array_choices[args[0].choice]);
 }
 
-static void set_pattern(const int32_t args[]) 
+static void set_brightness(const cmd_arg_t args[], uint8_t num_args)
 {
-    if (args[0] != 1 && args[0] != 2) {
-        printf("ERROR: Invalid pattern '%d'. Valid patterns are 1 or 2.\n", args[0]);
+    led_anim_set_brightness((uint8_t)args[0].i);
+    printf("OK: LED strip brightness %u%%\n", led_anim_brightness());
+}
+
+static void set_alarm_effect(const cmd_arg_t args[], uint8_t num_args)
+{
+    led_anim_set_alarm_effect((led_alarm_effect_t)args[0].choice);
+    printf("OK: LED alarm effect %s\n", alarm_effect_choices[args[0].choice]);
+}
+
+static void sensor_errors(const cmd_arg_t args[], uint8_t num_args)
+{
+    const dht20_stats_t* dht = dht20_get_stats();
+    const sensor_task_stats_t* task = get_sensor_task_stats();
+    const usb_tx_stats_t* tx = usb_tx_get_stats();
+    sample_queue_stats_t queue;
+    sample_queue_get_stats(&queue);
+
+    if (telemetry_binary())
+    {
+        telemetry_stats_msg_t msg = {
+            .samples = task->samples,
+            .retries = task->retries,
+            .failures = task->failures,
+            .i2c_errors = dht->i2c_errors,
+            .crc_errors = dht->crc_errors,
+            .busy_errors = dht->busy_errors,
+            .cal_errors = dht->cal_errors,
+            .queue_overflows = queue.overflows,
+            .tx_overruns = tx->records_dropped,
+        };
+        telemetry_send(MSG_STATS, &msg, sizeof(msg));
         return;
     }
-    set_led_strip_pattern((uint8_t)args[0]);
-    printf("LED strip pattern set to %d\n", args[0]);
+
+    printf("Sensor: %lu ok, %lu retries, %lu dropped, %lu alarm failures\n",
+           (unsigned long)task->samples,
+           (unsigned long)task->retries,
+           (unsigned long)task->failures,
+           (unsigned long)task->alarm_failures);
+    printf("  DHT20 frames ok: %lu\n", (unsigned long)dht->reads_ok);
+    printf("  i2c: %lu  crc: %lu  busy: %lu  cal: %lu\n",
+           (unsigned long)dht->i2c_errors,
+           (unsigned long)dht->crc_errors,
+           (unsigned long)dht->busy_errors,
+           (unsigned long)dht->cal_errors);
+
+    printf("  queue: %lu queued, %lu overflows\n",
+           (unsigned long)queue.pushed,
+           (unsigned long)queue.overflows);
+    printf("  usb tx: %lu bytes sent, %lu overruns (%lu bytes), high water %lu\n",
+           (unsigned long)tx->bytes_sent,
+           (unsigned long)tx->records_dropped,
+           (unsigned long)tx->bytes_dropped,
+           (unsigned long)tx->high_water);
+}
+
+static void event_info(const cmd_arg_t args[], uint8_t num_args)
+{
+    printf("Event dispatch latency (us):\n");
+    for (uint8_t i = 0; i < EVENT_COUNT; i++)
+    {
+        const event_stats_t* stats = event_get_stats((event_type_t)i);
+        uint32_t avg = stats->dispatched
+            ? (uint32_t)(stats->total_latency_us / stats->dispatched)
+            : 0;
+
+        printf("  %-8s n=%lu avg=%lu max=%lu\n",
+               event_name((event_type_t)i),
+               (unsigned long)stats->dispatched,
+               (unsigned long)avg,
+               (unsigned long)stats->max_latency_us);
+    }
 }
 
-// Command definitions
-static const cmd_entry_t sensor_commands[] = {
-    { .name = "temp", .handler = mock_temp, .num_args = 2, },
-    { .name = "humid", .handler = mock_humid, .num_args = 2, },
-    { .name = "mock", .handler = mock_sens, .num_args = 1, },
-    { .name = "unit", .handler = set_unit, .num_args = 1, },
-    { .name = "pattern", .handler = set_pattern, .num_args = 1, },
-};
+static void task_info(const cmd_arg_t args[], uint8_t num_args)
+{
+    printf("Tasks (us):     runs    avg    max  jitter  misses\n");
+    for (uint8_t i = 0; i < sched_task_count(); i++)
+    {
+        const sched_task_t* task = sched_get_task(i);
+        const task_stats_t* stats = &task->stats;
+        uint32_t avg = stats->runs ? (uint32_t)(stats->total_run_us / stats->runs) : 0;
+        uint32_t jitter = stats->runs ? stats->max_lateness_us - stats->min_lateness_us : 0;
+
+        printf("  %-10s %8lu %6lu %6lu %7lu %7lu\n",
+               task->name,
+               (unsigned long)stats->runs,
+               (unsigned long)avg,
+               (unsigned long)stats->max_run_us,
+               (unsigned long)jitter,
+               (unsigned long)stats->deadline_misses);
+    }
+
+    const led_anim_stats_t* anim = led_anim_get_stats();
+    uint32_t render_avg = anim->frames_rendered
+        ? (uint32_t)(anim->total_render_us / anim->frames_rendered)
+        : 0;
+    printf("LED animation: %lu frames rendered (avg %lu us, max %lu us), %lu idle, %lu fades\n",
+           (unsigned long)anim->frames_rendered,
+           (unsigned long)render_avg,
+           (unsigned long)anim->max_render_us,
+           (unsigned long)anim->frames_idle,
+           (unsigned long)anim->fades);
+
+    const led_strip_stats_t* strip = led_strip_get_stats();
+    printf("LED strip DMA: %lu frames sent, %lu unchanged skipped, %lu coalesced, %lu latch alarm failures\n",
+           (unsigned long)strip->frames_sent,
+           (unsigned long)strip->frames_skipped,
+           (unsigned long)strip->frames_coalesced,
+           (unsigned long)strip->latch_alarm_failures);
+}
+
+static void set_mode(const cmd_arg_t args[], uint8_t num_args)
+{
+    telemetry_set_mode((telemetry_mode_t)args[0].choice);
+
+    // binary decoders skip text between frames, so always confirm in text
+    printf("OK: output mode %s\n", mode_choices[args[0].choice]);
+}
+
+static void set_stream(const cmd_arg_t args[], uint8_t num_args)
+{
+    uint8_t hz = (uint8_t)args[0].i;
+
+    telemetry_set_stream(hz > 0);
+    set_sample_rate_hz(hz > 0 ? hz : SENSOR_DEFAULT_RATE_HZ);
+
+    if (hz > 0)
+    {
+        printf("OK: streaming at %u Hz (timestamp_ms,temp_c,humidity)\n", hz);
+    }
+    else
+    {
+        printf("OK: streaming stopped\n");
+    }
+}
+
+static void set_strip(const cmd_arg_t args[], uint8_t num_args)
+{
+    uint16_t length = (num_args > 1) ? (uint16_t)args[1].i : led_strip_length();
+
+    if (!led_strip_configure((uint8_t)args[0].i, length))
+    {
+        printf("Error: LED strip not available\n");
+        return;
+    }
+    printf("OK: %u strip(s) of %u LEDs on GP%u%s\n",
+           led_strip_count(), led_strip_length(),
+           (led_strip_count() > 1) ? 16u : 2u,
+           (led_strip_count() > 1) ? " upwards" : "");
+}
+
+static void flash_info(const cmd_arg_t args[], uint8_t num_args)
+{
+    if (num_args > 0 && args[0].choice == 1)
+    {
+        printf(flash_store_flush() ? "OK: flash store flushed\n" : "ERROR: flash write failed\n");
+        return;
+    }
+
+    if (num_args > 0 && args[0].choice == 2)
+    {
+        uint32_t first;
+        uint32_t next;
+        flash_store_page_range(&first, &next);
+
+        size_t held = next - first;
+        size_t n = telemetry_dump_flash((num_args > 1) ? (size_t)args[1].i : held);
+        printf("OK: sending %lu of %lu flash pages (timestamp_ms,temp_c,humidity)\n",
+               (unsigned long)n, (unsigned long)held);
+        return;
+    }
+
+    flash_store_stats_t stats;
+    uint32_t first;
+    uint32_t next;
+    flash_store_get_stats(&stats);
+    flash_store_page_range(&first, &next);
+
+    printf("Flash store: pages %lu..%lu held, %lu samples buffered\n",
+           (unsigned long)first, (unsigned long)next,
+           (unsigned long)flash_store_buffered());
+    printf("  written: %lu pages, %lu sector erases\n",
+           (unsigned long)stats.pages_written,
+           (unsigned long)stats.sectors_erased);
+    printf("  errors: %lu write, %lu crc\n",
+           (unsigned long)stats.write_errors,
+           (unsigned long)stats.crc_errors);
+    printf("  wear: sector erase count %lu..%lu\n",
+           (unsigned long)stats.min_erase_count,
+           (unsigned long)stats.max_erase_count);
+}
+
+static void dump_history(const cmd_arg_t args[], uint8_t num_args)
+{
+    const history_stats_t* stats = history_get_stats();
+    size_t held = history_count();
+    size_t bytes = history_bytes_used();
+    size_t n = telemetry_dump_history((num_args > 0) ? (size_t)args[0].i : held);
+
+    // integer hundredths of a byte per sample and nanoseconds per encode
+    uint32_t centi_bytes = held ? (uint32_t)(bytes * 100 / held) : 0;
+    uint32_t encode_ns = stats->samples ? (uint32_t)(stats->encode_total_us * 1000 / stats->samples) : 0;
+
+    uint8_t fields = telemetry_fields();
+    printf("OK: sending %lu of %lu samples (timestamp_ms,temp_c,humidity%s%s%s)\n",
+           (unsigned long)n, (unsigned long)held,
+           (fields & PSYCHRO_DEW_POINT) ? ",dew_c" : "",
+           (fields & PSYCHRO_HEAT_INDEX) ? ",heat_c" : "",
+           (fields & PSYCHRO_ABS_HUMIDITY) ? ",abs_g_m3" : "");
+    printf("  %lu bytes held, %lu.%02lu bytes/sample, encode avg %lu ns\n",
+           (unsigned long)bytes,
+           (unsigned long)(centi_bytes / 100),
+           (unsigned long)(centi_bytes % 100),
+           (unsigned long)encode_ns);
+}
+
+static void show_trend(const cmd_arg_t args[], uint8_t num_args)
+{
+    rrd_tier_t tier = (rrd_tier_t)args[0].choice;
+    size_t held = rrd_count(tier);
+    size_t n = (num_args > 1 && (size_t)args[1].i < held) ? (size_t)args[1].i : held;
+    char unit = get_unit_symbol();
+
+    if (num_args < 2 && n > 10)
+    {
+        n = 10;
+    }
+
+    printf("%s tier: %lu s buckets, %lu held, newest last\n",
+           tier_choices[tier],
+           (unsigned long)(rrd_period_ms(tier) / 1000),
+           (unsigned long)held);
+    printf("  since boot      n   temp min/mean/max (%c)   humid min/mean/max (%%)\n", unit);
+
+    for (size_t age = n; age > 0; age--)
+    {
+        rrd_bucket_t bucket;
+        uint32_t s;
+        if (!rrd_get(tier, age - 1, &bucket, &s))
+        {
+            continue;
+        }
+
+        printf("  %4lu:%02lu:%02lu %6u",
+               (unsigned long)(s / 3600),
+               (unsigned long)(s / 60 % 60),
+               (unsigned long)(s % 60),
+               bucket.count);
+        if (bucket.count == 0)
+        {
+            printf("   -\n");
+            continue;
+        }
+
+        char text[6][12];
+        fixed_format_tenths(text[0], sizeof(text[0]), convert_temp(bucket.temp_min));
+        fixed_format_tenths(text[1], sizeof(text[1]), convert_temp(bucket.temp_mean));
+        fixed_format_tenths(text[2], sizeof(text[2]), convert_temp(bucket.temp_max));
+        fixed_format_tenths(text[3], sizeof(text[3]), bucket.humidity_min);
+        fixed_format_tenths(text[4], sizeof(text[4]), bucket.humidity_mean);
+        fixed_format_tenths(text[5], sizeof(text[5]), bucket.humidity_max);
+        printf("   %6s %6s %6s   %6s %6s %6s\n",
+               text[0], text[1], text[2], text[3], text[4], text[5]);
+    }
+}
+
+static void print_rolling(const char* name, const rolling_summary_t* s, bool temp)
+{
+    char text[6][12];
+    int32_t sd = s->stddev;
+
+    if (temp)
+    {
+        // a spread only scales between units; the offset cancels
+        if (get_temp_unit() == TEMP_FAHRENHEIT)
+        {
+            sd = sd * 9 / 5;
+        }
+        fixed_format_hundredths(text[0], sizeof(text[0]), convert_temp(s->last));
+        fixed_format_hundredths(text[1], sizeof(text[1]), convert_temp(s->ema));
+        fixed_format_hundredths(text[2], sizeof(text[2]), convert_temp(s->min));
+        fixed_format_hundredths(text[3], sizeof(text[3]), convert_temp(s->max));
+        fixed_format_hundredths(text[4], sizeof(text[4]), convert_temp(s->mean));
+    }
+    else
+    {
+        fixed_format_hundredths(text[0], sizeof(text[0]), s->last);
+        fixed_format_hundredths(text[1], sizeof(text[1]), s->ema);
+        fixed_format_hundredths(text[2], sizeof(text[2]), s->min);
+        fixed_format_hundredths(text[3], sizeof(text[3]), s->max);
+        fixed_format_hundredths(text[4], sizeof(text[4]), s->mean);
+    }
+    fixed_format_hundredths(text[5], sizeof(text[5]), sd);
+
+    printf("  %-6s %7s %7s %7s %7s %7s %6s\n",
+           name, text[0], text[1], text[2], text[3], text[4], text[5]);
+}
+
+static void rolling_info(const cmd_arg_t args[], uint8_t num_args)
+{
+    rolling_summary_t temp;
+    rolling_summary_t humidity;
+
+    if (num_args > 0 && args[0].choice == 1)
+    {
+        rolling_stats_reset();
+        printf("OK: running mean/stddev reset\n");
+        return;
+    }
+
+    if (!rolling_stats_get(ROLLING_TEMP, &temp) || !rolling_stats_get(ROLLING_HUMIDITY, &humidity))
+    {
+        printf("No samples yet\n");
+        return;
+    }
+
+    printf("ema 1/%d, min/max over last %d samples, mean/sd over %lu samples since reset\n",
+           1 << ROLLING_EMA_SHIFT, ROLLING_WINDOW, (unsigned long)temp.count);
+    printf("  %-6s %7s %7s %7s %7s %7s %6s\n", "", "now", "ema", "min", "max", "mean", "sd");
+    print_rolling(get_unit_symbol() == 'F' ? "temp F" : "temp C", &temp, true);
+    print_rolling("hum %", &humidity, false);
+}
+
+static void filter_info(const cmd_arg_t args[], uint8_t num_args)
+{
+    const sample_filter_stats_t* stats = sample_filter_get_stats();
+    uint16_t k = sample_filter_get_k();
+
+    if (num_args > 0 && args[0].choice == 1)
+    {
+        sample_filter_reset_stats();
+        printf("OK: filter counters reset\n");
+        return;
+    }
+
+    printf("median of %u, hampel k %u.%02u%s\n",
+           sample_filter_get_window(), k / 100, k % 100, (k == 0) ? " (gate off)" : "");
+    printf("  accepted %lu, rejected temp %lu, rejected humidity %lu\n",
+           (unsigned long)stats->accepted,
+           (unsigned long)stats->rejected_temp,
+           (unsigned long)stats->rejected_humidity);
+}
+
+static void set_median(const cmd_arg_t args[], uint8_t num_args)
+{
+    sample_filter_set_window((uint8_t)args[0].i);
+    printf("OK: median window set to %ld\n", (long)args[0].i);
+}
+
+static void set_hampel(const cmd_arg_t args[], uint8_t num_args)
+{
+    char text[12];
+
+    sample_filter_set_k((uint16_t)args[0].centi);
+    fixed_format_hundredths(text, sizeof(text), args[0].centi);
+    printf("OK: hampel threshold set to %s MADs\n", text);
+}
+
+static void set_lcd_line(const cmd_arg_t args[], uint8_t num_args)
+{
+    set_lcd_field((uint8_t)(args[0].i - 1), (lcd_field_t)args[1].choice);
+    printf("OK: LCD line %ld shows %s\n", (long)args[0].i, lcd_field_choices[args[1].choice]);
+}
+
+static void set_field(const cmd_arg_t args[], uint8_t num_args)
+{
+    uint8_t bit = (uint8_t)(1u << args[0].choice);
+    uint8_t fields = telemetry_fields();
+
+    telemetry_set_fields(args[1].choice ? (fields | bit) : (fields & ~bit));
+    printf("OK: telemetry field %s %s\n", field_choices[args[0].choice], on_off_choices[args[1].choice]);
+}
+
+static void print_rule(uint8_t index)
+{
+    alarm_rule_t rule;
+    char threshold[12];
+    char hysteresis[12];
+
+    if (!alarm_get_rule(index, &rule))
+    {
+        return;
+    }
+
+    bool rate = (rule.kind == ALARM_RISE || rule.kind == ALARM_FALL);
+    fixed_format_hundredths(threshold, sizeof(threshold), rule.threshold);
+    fixed_format_hundredths(hysteresis, sizeof(hysteresis), rule.hysteresis);
+    printf("  %u: %s %s %s%s hyst %s hold %lu s, fired %lu%s\n",
+           index,
+           alarm_channel_choices[rule.channel],
+           alarm_kind_choices[rule.kind],
+           threshold, rate ? "/min" : "",
+           hysteresis,
+           (unsigned long)(rule.hold_ms / 1000),
+           (unsigned long)alarm_fire_count(index),
+           (alarm_active_mask() & (1u << index)) ? "  ACTIVE" : "");
+}
+
+static void alarm_info(const cmd_arg_t args[], uint8_t num_args)
+{
+    uint8_t action = (num_args > 0) ? args[0].choice : 0;
+
+    if (action == 1)
+    {
+        if (num_args < 2 || args[1].i >= ALARM_MAX_RULES)
+        {
+            printf("Error: alarm delete needs a rule number 0-%d\n", ALARM_MAX_RULES - 1);
+            return;
+        }
+        alarm_delete_rule((uint8_t)args[1].i);
+        printf("OK: rule %ld deleted\n", (long)args[1].i);
+        return;
+    }
+
+    if (action == 2)
+    {
+        // replay what the queue still holds, oldest first
+        uint32_t head = alarm_event_head();
+        uint32_t cursor = (head > ALARM_EVENT_QUEUE_SIZE) ? head - ALARM_EVENT_QUEUE_SIZE : 0;
+        alarm_event_t ev;
+
+        printf("%lu alarm events since boot\n", (unsigned long)head);
+        while (alarm_event_read(&cursor, &ev))
+        {
+            char value[12];
+            fixed_format_hundredths(value, sizeof(value), ev.value);
+            printf("  %10lu ms  rule %u %s %s %s %s\n",
+                   (unsigned long)ev.timestamp_ms, ev.rule,
+                   alarm_channel_choices[ev.channel], alarm_kind_choices[ev.kind],
+                   ev.fired ? "fired" : "cleared", value);
+        }
+        return;
+    }
+
+    printf("alarm rules (values in C, %%, or per minute for rise/fall):\n");
+    for (uint8_t i = 0; i < ALARM_MAX_RULES; i++)
+    {
+        print_rule(i);
+    }
+}
+
+static void set_rule(const cmd_arg_t args[], uint8_t num_args)
+{
+    alarm_rule_t rule = {
+        .enabled = true,
+        .channel = args[1].choice,
+        .kind = args[2].choice,
+        .threshold = args[3].centi,
+        .hysteresis = (num_args > 4) ? args[4].centi : 0,
+        .hold_ms = (num_args > 5) ? (uint32_t)args[5].i * 1000 : 0,
+    };
+
+    if (!alarm_set_rule((uint8_t)args[0].i, &rule))
+    {
+        printf("Error: invalid rule\n");
+        return;
+    }
+    printf("OK: rule set\n");
+    print_rule((uint8_t)args[0].i);
+}
 
-void commands_init(void)
+static void set_view(const cmd_arg_t args[], uint8_t num_args)
 {
-    // Register each command
-    for (size_t i = 0; i < sizeof(sensor_commands) / sizeof(sensor_commands[0]); i++) {
-        cmd_register(&sensor_commands[i]);
+    set_lcd_view((lcd_view_t)args[0].choice);
+    printf("OK: LCD view set to %s\n", view_choices[args[0].choice]);
+}
+
+static void show_config(const cmd_arg_t args[], uint8_t num_args)
+{
+    if (telemetry_binary())
+    {
+        telemetry_config_msg_t msg = {
+            .temp_unit = (uint8_t)get_temp_unit(),
+            .led_pattern = get_led_strip_pattern(),
+            .mock = get_mock_sensor(),
+        };
+        telemetry_send(MSG_CONFIG, &msg, sizeof(msg));
+        return;
     }
+
+    uint8_t fields = telemetry_fields();
+    printf("unit: %s  pattern: %d  mock: %s  array: %s\n",
+           unit_choices[get_temp_unit()],
+           get_led_strip_pattern(),
+           on_off_choices[get_mock_sensor()],
+           array_choices[get_led_array_pwm()]);
+    printf("strips: %u x %u LEDs  brightness: %u%%  alarm effect: %s\n",
+           led_strip_count(), led_strip_length(),
+           led_anim_brightness(),
+           alarm_effect_choices[led_anim_alarm_effect()]);
+    printf("lcd: %s/%s  fields:%s%s%s%s\n",
+           lcd_field_choices[get_lcd_field(0)],
+           lcd_field_choices[get_lcd_field(1)],
+           (fields == 0) ? " none" : "",
+           (fields & PSYCHRO_DEW_POINT) ? " dew" : "",
+           (fields & PSYCHRO_HEAT_INDEX) ? " heat" : "",
+           (fields & PSYCHRO_ABS_HUMIDITY) ? " abs" : "");
 }
+
+// Command registry, kept sorted by name for binary search
+const cmd_entry_t command_table[] = {
+    { .name = "alarm", .handler = alarm_info, .num_args = 2, .optional_args = 2,
+      .args = { ARG_ENUM("list|delete|events", alarm_choices), ARG_INT("n", 0, ALARM_MAX_RULES - 1) }, },
+    { .name = "alarmfx", .handler = set_alarm_effect, .num_args = 1,
+      .args = { ARG_ENUM("solid|pulse|blink", alarm_effect_choices) }, },
+    { .name = "array", .handler = set_array_mode, .num_args = 1,
+      .args = { ARG_ENUM("step|pwm", array_choices) }, },
+    { .name = "brightness", .handler = set_brightness, .num_args = 1,
+      .args = { ARG_INT("percent", 0, 100) }, },
+    { .name = "config", .handler = show_config, .num_args = 0, },
+    { .name = "errors", .handler = sensor_errors, .num_args = 0, },
+    { .name = "events", .handler = event_info, .num_args = 0, },
+    { .name = "field", .handler = set_field, .num_args = 2,
+      .args = { ARG_ENUM("dew|heat|abs", field_choices), ARG_ENUM("off|on", on_off_choices) }, },
+    { .name = "filter", .handler = filter_info, .num_args = 1, .optional_args = 1,
+      .args = { ARG_ENUM("show|reset", filter_choices) }, },
+    { .name = "flash", .handler = flash_info, .num_args = 2, .optional_args = 2,
+      .args = { ARG_ENUM("info|flush|dump", flash_choices), ARG_INT("pages", 1, INT32_MAX) }, },
+    { .name = "hampel", .handler = set_hampel, .num_args = 1,
+      .args = { ARG_DECIMAL("k", 0, 10) }, },
+    { .name = "help", .handler = cmd_help, .num_args = 0, },
+    { .name = "history", .handler = dump_history, .num_args = 1, .optional_args = 1,
+      .args = { ARG_INT("n", 1, INT32_MAX) }, },
+    { .name = "humid", .handler = mock_humid, .num_args = 1,
+      .args = { ARG_DECIMAL("percent", 0, 100) }, },
+    { .name = "lcd", .handler = set_lcd_line, .num_args = 2,
+      .args = { ARG_INT("1|2", 1, 2), ARG_ENUM("temp|humid|dew|heat|abs", lcd_field_choices) }, },
+    { .name = "median", .handler = set_median, .num_args = 1,
+      .args = { ARG_INT("n", 1, FILTER_MAX_WINDOW) }, },
+    { .name = "mock", .handler = mock_sens, .num_args = 1,
+      .args = { ARG_ENUM("off|on", on_off_choices) }, },
+    { .name = "mode", .handler = set_mode, .num_args = 1,
+      .args = { ARG_ENUM("text|binary", mode_choices) }, },
+    { .name = "pattern", .handler = set_pattern, .num_args = 1,
+      .args = { ARG_INT("1|2", 1, 2) }, },
+    { .name = "rule", .handler = set_rule, .num_args = 6, .optional_args = 2,
+      .args = { ARG_INT("n", 0, ALARM_MAX_RULES - 1),
+                ARG_ENUM("temp|humid|dew|heat", alarm_channel_choices),
+                ARG_ENUM("high|low|rise|fall", alarm_kind_choices),
+                ARG_DECIMAL("value", -100, 200),
+                ARG_DECIMAL("hysteresis", 0, 100),
+                ARG_INT("hold_s", 0, 3600) }, },
+    { .name = "stats", .handler = rolling_info, .num_args = 1, .optional_args = 1,
+      .args = { ARG_ENUM("show|reset", stats_choices) }, },
+    { .name = "stream", .handler = set_stream, .num_args = 1,
+      .args = { ARG_INT("hz", 0, SENSOR_MAX_RATE_HZ) }, },
+    { .name = "strip", .handler = set_strip, .num_args = 2, .optional_args = 1,
+      .args = { ARG_INT("count", 1, LED_STRIP_MAX_STRIPS), ARG_INT("length", 1, LED_STRIP_MAX_PIXELS) }, },
+    { .name = "tasks", .handler = task_info, .num_args = 0, },
+    { .name = "temp", .handler = mock_temp, .num_args = 1,
+      .args = { ARG_DECIMAL("celsius", -50, 150) }, },
+    { .name = "trend", .handler = show_trend, .num_args = 2, .optional_args = 1,
+      .args = { ARG_ENUM("raw|minute|hour", tier_choices), ARG_INT("n", 1, RRD_HOUR_BUCKETS) }, },
+    { .name = "unit", .handler = set_unit, .num_args = 1,
+      .args = { ARG_ENUM("C|F", unit_choices) }, },
+    { .name = "view", .handler = set_view, .num_args = 1,
+      .args = { ARG_ENUM("raw|smooth", view_choices) }, },
+};
+
+const size_t command_table_size = sizeof(command_table) / sizeof(command_table[0]);
@@ -1,5 +1,6 @@
 #pragma once
 
-#include <stdio.h>
+// Command handlers and the static command registry (command_table)
 
-void commands_init(void);
+#include <stdio.h>
+#include "command_interface.h"
@@ -1,79 +1,273 @@
+#include <ctype.h>
 #include "parse.h"
 
 /**
- * @brief converts an string argument to a long if possible
+ * @brief splits the next space separated token off a command line
+ *
+ * The token is NUL terminated in place and the cursor is advanced past
+ * it, so a line is scanned exactly once
+ *
+ * @param cursor position in the command line, updated on return
+ *
+ * @return the token, or NULL at the end of the line
+ *
+ */
+char* parse_token(char** cursor)
+{
+    char* p = *cursor;
+
+    while (*p == ' ')
+    {
+        p++;
+    }
+    if (*p == '\0')
+    {
+        *cursor = p;
+        return NULL;
+    }
+
+    char* token = p;
+    while (*p != ' ' && *p != '\0')
+    {
+        p++;
+    }
+    if (*p == ' ')
+    {
+        *p++ = '\0';
+    }
+
+    *cursor = p;
+    return token;
+}
+
+/**
+ * @brief converts a string argument to an integer if possible
+ *
+ * Accepts an optional sign and decimal or 0x hex digits
  *
  * @param arg the argument as a string to convert
- * @param value the long pointer to place the converted value
+ * @param value location to place the converted value
  *
  * @return true if conversion successful false otherwise
  *
  */
-static bool convert_arg(char* arg, long* value)
+static bool convert_int(const char* arg, int32_t* value)
 {
-    char* endptr;
+    bool negative = (*arg == '-');
+    if (*arg == '-' || *arg == '+')
+    {
+        arg++;
+    }
+
+    uint32_t base = 10;
+    if (arg[0] == '0' && (arg[1] == 'x' || arg[1] == 'X') && arg[2] != '\0')
+    {
+        base = 16;
+        arg += 2;
+    }
 
-    // convert both hex and decimal strings
-    if (strlen(arg) > 2 && arg[0] == '0' && 
-        (arg[1] == 'x' || arg[1] == 'X')) {
-        *value = strtol(arg, &endptr, 16);
-    } else {
-        *value = strtol(arg, &endptr, 10);
+    if (*arg == '\0')
+    {
+        return false;
     }
-    
-    // return true if parsing was successful
-    return (endptr != arg && *endptr == '\0');
 
+    uint32_t magnitude = 0;
+    for (; *arg != '\0'; arg++)
+    {
+        uint32_t digit;
+        if (*arg >= '0' && *arg <= '9')
+            digit = *arg - '0';
+        else if (base == 16 && isxdigit((unsigned char)*arg))
+            digit = (tolower((unsigned char)*arg) - 'a') + 10;
+        else
+            return false;
+
+        if (magnitude > (UINT32_MAX - digit) / base)
+            return false; // overflow
+        magnitude = magnitude * base + digit;
+    }
+
+    if (magnitude > (negative ? 0x80000000u : (uint32_t)INT32_MAX))
+    {
+        return false;
+    }
+    *value = negative ? (int32_t)(0u - magnitude) : (int32_t)magnitude;
+    return true;
 }
 
 /**
- * @brief parses a command line string into a command and args
+ * @brief converts a decimal string (e.g. "-12.75") to centi-units
  *
- * @param cmd_line command line to parse
- * @param cmd char pointer to place command into
- * @param args array to place command arguments
+ * Digits past the second decimal place round the result
  *
- * @return number of arguments parsed
+ * @param arg the argument as a string to convert
+ * @param value location to place the value * 100
  *
+ * @return true if conversion successful false otherwise
  */
-bool parse_line(char* cmd_line, parsed_cmd_t* parsed_cmd)
+static bool convert_decimal(const char* arg, int32_t* value)
 {
-    uint8_t count = 0;
-    char* token;
-    char* saveptr;
-    
-    token = strtok_r(cmd_line, " ", &saveptr);
+    bool negative = (*arg == '-');
+    if (*arg == '-' || *arg == '+')
+    {
+        arg++;
+    }
+
+    uint32_t whole = 0;
+    uint32_t frac = 0;
+    uint8_t frac_digits = 0;
+    bool seen_digit = false;
+    bool in_frac = false;
 
-    // save first token in cmd_line
-    if (token != NULL)
+    for (; *arg != '\0'; arg++)
     {
-        if (strlen(token) >= CMD_MAX_LEN)
+        if (*arg == '.' && !in_frac)
+        {
+            in_frac = true;
+            continue;
+        }
+        if (*arg < '0' || *arg > '9')
         {
-            printf("WARNING: command needs to be less than %d characters\n", CMD_MAX_LEN);
             return false;
         }
-        strncpy(parsed_cmd->cmd, token, CMD_MAX_LEN);
+
+        uint32_t digit = *arg - '0';
+        seen_digit = true;
+
+        if (!in_frac)
+        {
+            if (whole > 2000000) // keeps whole * 100 within int32_t
+                return false;
+            whole = whole * 10 + digit;
+        }
+        else if (frac_digits < 2)
+        {
+            frac = frac * 10 + digit;
+            frac_digits++;
+        }
+        else if (frac_digits == 2)
+        {
+            frac += (digit >= 5); // round on the third place
+            frac_digits++;
+        }
     }
-    
-    token = strtok_r(NULL, " ", &saveptr);
 
-    // get the args
-    while (token != NULL) 
+    if (!seen_digit)
     {
-        long value;
-        if (convert_arg(token, &value)) 
+        return false;
+    }
+    if (frac_digits == 1)
+    {
+        frac *= 10;
+    }
+
+    int32_t centi = (int32_t)(whole * 100 + frac);
+    *value = negative ? -centi : centi;
+    return true;
+}
+
+/**
+ * @brief case-insensitive string equality
+ */
+static bool equals_nocase(const char* a, const char* b)
+{
+    for (; *a != '\0' && *b != '\0'; a++, b++)
+    {
+        if (tolower((unsigned char)*a) != tolower((unsigned char)*b))
+            return false;
+    }
+    return *a == *b;
+}
+
+/**
+ * @brief converts an enum argument given by name or by index
+ *
+ * @return true if the argument names a choice
+ */
+static bool convert_enum(const char* arg, const char* const* choices, uint8_t* choice)
+{
+    uint8_t count = 0;
+    for (; choices[count] != NULL; count++)
+    {
+        if (equals_nocase(arg, choices[count]))
         {
-            parsed_cmd->args[count++] = (int32_t)value;
-        } 
-        else 
+            *choice = count;
+            return true;
+        }
+    }
+
+    // numeric index keeps the old "unit 1" style working
+    int32_t index;
+    if (convert_int(arg, &index) && index >= 0 && index < count)
+    {
+        *choice = (uint8_t)index;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief validates and converts one argument against its schema
+ *
+ * @param token the argument as a string
+ * @param spec the schema the argument must satisfy
+ * @param out location to place the converted value
+ *
+ * @return true if the argument is valid, false (with a warning) otherwise
+ *
+ */
+bool parse_arg(const char* token, const cmd_arg_spec_t* spec, cmd_arg_t* out)
+{
+    switch (spec->type)
+    {
+    case CMD_ARG_INT:
+    case CMD_ARG_DECIMAL:
+    {
+        int32_t value;
+        bool ok = (spec->type == CMD_ARG_INT)
+            ? convert_int(token, &value)
+            : convert_decimal(token, &value);
+
+        if (!ok)
+        {
+            printf("WARNING: Could not parse '%s' as %s\n", token,
+                   (spec->type == CMD_ARG_INT) ? "integer" : "decimal");
+            return false;
+        }
+        if (value < spec->min || value > spec->max)
         {
-            printf("WARNING: Could not parse '%s' as integer\n", token);
+            printf("WARNING: %s '%s' out of range\n", spec->name, token);
             return false;
         }
-        
-        token = strtok_r(NULL, " ", &saveptr);
+        out->i = value;
+        return true;
     }
-    
-    parsed_cmd->num_args = count;
-    return true;
+
+    case CMD_ARG_ENUM:
+        if (!convert_enum(token, spec->choices, &out->choice))
+        {
+            printf("WARNING: '%s' is not a valid %s\n", token, spec->name);
+            return false;
+        }
+        return true;
+
+    case CMD_ARG_STRING:
+    {
+        uint8_t i = 0;
+        for (; token[i] != '\0'; i++)
+        {
+            if (i >= CMD_ARG_STR_LEN - 1)
+            {
+                printf("WARNING: %s needs to be less than %d characters\n",
+                       spec->name, CMD_ARG_STR_LEN);
+                return false;
+            }
+            out->str[i] = token[i];
+        }
+        out->str[i] = '\0';
+        return true;
+    }
+    }
+
+    return false;
 }
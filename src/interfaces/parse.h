@@ -6,15 +6,47 @@
 #include <string.h>
 #include <stdlib.h>
 
-#define CMD_MAX_ARGS 16
+#define CMD_MAX_ARGS 6
 #define CMD_MAX_LEN 16
+#define CMD_ARG_STR_LEN 16
 
+// Argument types a command can declare
+typedef enum
+{
+    CMD_ARG_INT,       // decimal or 0x hex integer
+    CMD_ARG_DECIMAL,   // fixed-point decimal, up to 2 places (e.g. 22.5)
+    CMD_ARG_ENUM,      // one of a list of names, or its index
+    CMD_ARG_STRING     // short word, up to CMD_ARG_STR_LEN - 1 chars
+} cmd_arg_type_t;
+
+// Declarative schema for one argument
 typedef struct
 {
-    char cmd[CMD_MAX_LEN];
-    int32_t args[CMD_MAX_ARGS];
-    uint8_t num_args;
-} parsed_cmd_t;
+    cmd_arg_type_t type;
+    const char* name;             // shown by help, e.g. "<celsius>"
+    int32_t min;                  // INT / DECIMAL range (DECIMAL in centi-units)
+    int32_t max;
+    const char* const* choices;   // ENUM names, NULL terminated
+} cmd_arg_spec_t;
+
+// Converted argument value
+typedef union
+{
+    int32_t i;                    // CMD_ARG_INT
+    int32_t centi;                // CMD_ARG_DECIMAL, value * 100
+    uint8_t choice;               // CMD_ARG_ENUM, index into choices
+    char str[CMD_ARG_STR_LEN];    // CMD_ARG_STRING
+} cmd_arg_t;
 
-bool parse_line(char* cmd_line, parsed_cmd_t* parsed_cmd);
+// Schema helpers for command tables
+#define ARG_INT(name_, min_, max_) \
+    { .type = CMD_ARG_INT, .name = (name_), .min = (min_), .max = (max_) }
+#define ARG_DECIMAL(name_, min_, max_) \
+    { .type = CMD_ARG_DECIMAL, .name = (name_), .min = (min_) * 100, .max = (max_) * 100 }
+#define ARG_ENUM(name_, choices_) \
+    { .type = CMD_ARG_ENUM, .name = (name_), .choices = (choices_) }
+#define ARG_STRING(name_) \
+    { .type = CMD_ARG_STRING, .name = (name_) }
 
+char* parse_token(char** cursor);
+bool parse_arg(const char* token, const cmd_arg_spec_t* spec, cmd_arg_t* out);
@@ -0,0 +1,456 @@
+/**
+ * @file telemetry.c
+ * @brief Binary framed telemetry on the USB CDC link
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "telemetry.h"
+#include "usb_tx.h"
+#include "../app/crc16.h"
+#include "../app/fixed_point.h"
+#include "../app/psychro.h"
+#include "../app/alarm.h"
+#include "../app/sample_history.h"
+#include "../app/flash_store.h"
+#include "../app/events.h"
+
+#define SAMPLE_RECORD_MAX 64   // longest CSV line or encoded sample frame
+#define HISTORY_CHUNK 16       // history entries queued per scheduler pass
+
+// type + seq + payload + crc, and the COBS worst case adds one byte per 254
+#define FRAME_MAX_RAW (2 + TELEMETRY_MAX_PAYLOAD + 2)
+#define FRAME_MAX_ENCODED (FRAME_MAX_RAW + FRAME_MAX_RAW / 254 + 1)
+
+static telemetry_mode_t mode = TELEMETRY_TEXT;
+static bool streaming = false;
+static uint8_t fields = 0;   // derived metrics added to each sample
+static uint8_t seq = 0;
+
+// dump in progress: history entries or flash pages [dump_next, dump_end)
+// are left to send
+static bool dumping = false;
+static bool dump_flash = false;
+static uint32_t dump_next;
+static uint32_t dump_end;
+static uint32_t dump_skipped;
+static codec_decoder_t page_decoder;   // flash page being sent
+static uint16_t page_left = 0;         // samples left in that page
+
+static uint32_t alarm_cursor = 0;   // next alarm event to report
+
+/**
+ * @brief COBS encode a buffer so the output contains no zero bytes
+ *
+ * @param in data to encode
+ * @param len length of in
+ * @param out destination, at least len + len / 254 + 1 bytes
+ *
+ * @return encoded length
+ */
+static size_t cobs_encode(const uint8_t* in, size_t len, uint8_t* out)
+{
+    size_t code_pos = 0;   // where the current block's length code goes
+    size_t out_pos = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (in[i] != 0)
+        {
+            out[out_pos++] = in[i];
+            code++;
+        }
+
+        if (in[i] == 0 || code == 0xFF)
+        {
+            out[code_pos] = code;
+            code_pos = out_pos++;
+            code = 1;
+        }
+    }
+
+    out[code_pos] = code;
+    return out_pos;
+}
+
+/**
+ * @brief select text or binary output for this session
+ */
+void telemetry_set_mode(telemetry_mode_t new_mode)
+{
+    mode = new_mode;
+}
+
+/**
+ * @brief true if the session is in binary mode
+ */
+bool telemetry_binary(void)
+{
+    return mode == TELEMETRY_BINARY;
+}
+
+/**
+ * @brief frame, encode and send one message
+ *
+ * @param type message type
+ * @param payload message body, already little-endian
+ * @param len payload length, at most TELEMETRY_MAX_PAYLOAD
+ *
+ * @return true if queued, false if too long or dropped by the TX ring
+ */
+bool telemetry_send(telemetry_msg_type_t type, const void* payload, size_t len)
+{
+    uint8_t raw[FRAME_MAX_RAW];
+    uint8_t encoded[FRAME_MAX_ENCODED + 2];
+
+    if (len > TELEMETRY_MAX_PAYLOAD)
+    {
+        return false;
+    }
+
+    raw[0] = (uint8_t)type;
+    raw[1] = seq++;
+    memcpy(&raw[2], payload, len);
+
+    uint16_t crc = crc16_ccitt(raw, len + 2);
+    raw[len + 2] = (uint8_t)crc;
+    raw[len + 3] = (uint8_t)(crc >> 8);
+
+    // leading and trailing delimiters isolate the frame from stray text
+    encoded[0] = 0x00;
+    size_t n = cobs_encode(raw, len + 4, &encoded[1]);
+    encoded[n + 1] = 0x00;
+
+    return usb_tx_write(encoded, n + 2);
+}
+
+/**
+ * @brief turn continuous text output of samples on or off
+ */
+void telemetry_set_stream(bool on)
+{
+    streaming = on;
+}
+
+/**
+ * @brief true if samples are streamed in text mode
+ */
+bool telemetry_streaming(void)
+{
+    return streaming;
+}
+
+/**
+ * @brief choose the derived metrics sent with each sample
+ *
+ * @param selected psychro_metric_t bits, 0 for plain samples
+ */
+void telemetry_set_fields(uint8_t selected)
+{
+    fields = selected & PSYCHRO_ALL;
+}
+
+/**
+ * @brief derived metrics sent with each sample (psychro_metric_t bits)
+ */
+uint8_t telemetry_fields(void)
+{
+    return fields;
+}
+
+/**
+ * @brief queue one sample as a CSV line: timestamp_ms,temp_c,humidity
+ * followed by the selected derived metrics (dew_c, heat_c, abs_g_m3)
+ */
+static bool send_sample_csv(const sensor_sample_t* sample)
+{
+    char text[12];
+    char line[SAMPLE_RECORD_MAX];
+    int len;
+
+    fixed_format_hundredths(text, sizeof(text), sample->temp);
+    len = snprintf(line, sizeof(line), "%lu,%s", (unsigned long)sample->timestamp_ms, text);
+    fixed_format_hundredths(text, sizeof(text), sample->humidity);
+    len += snprintf(line + len, sizeof(line) - len, ",%s", text);
+
+    if (fields != 0)
+    {
+        psychro_t derived;
+        psychro_compute(sample->temp, sample->humidity, &derived);
+        const int32_t values[] = {derived.dew_point, derived.heat_index, derived.abs_humidity};
+
+        for (uint8_t i = 0; i < 3; i++)
+        {
+            if (fields & (1u << i))
+            {
+                fixed_format_hundredths(text, sizeof(text), values[i]);
+                len += snprintf(line + len, sizeof(line) - len, ",%s", text);
+            }
+        }
+    }
+    len += snprintf(line + len, sizeof(line) - len, "\n");
+
+    return usb_tx_write(line, (size_t)len);
+}
+
+/**
+ * @brief queue one sample in the session's format: frame or CSV line
+ */
+static bool write_sample(const sensor_sample_t* sample)
+{
+    if (mode != TELEMETRY_BINARY)
+    {
+        return send_sample_csv(sample);
+    }
+
+    if (fields != 0)
+    {
+        psychro_t derived;
+        psychro_compute(sample->temp, sample->humidity, &derived);
+
+        telemetry_derived_msg_t msg = {
+            .timestamp_ms = sample->timestamp_ms,
+            .temp = sample->temp,
+            .humidity = sample->humidity,
+            .fields = fields,
+            .dew_point = (fields & PSYCHRO_DEW_POINT) ? derived.dew_point : 0,
+            .heat_index = (fields & PSYCHRO_HEAT_INDEX) ? derived.heat_index : 0,
+            .abs_humidity = (fields & PSYCHRO_ABS_HUMIDITY) ? derived.abs_humidity : 0,
+        };
+        return telemetry_send(MSG_SAMPLE_DERIVED, &msg, sizeof(msg));
+    }
+
+    // RP2040 is little-endian, so the packed struct is the wire format
+    telemetry_sample_msg_t msg = {
+        .timestamp_ms = sample->timestamp_ms,
+        .temp = sample->temp,
+        .humidity = sample->humidity,
+    };
+    return telemetry_send(MSG_SAMPLE, &msg, sizeof(msg));
+}
+
+/**
+ * @brief send a live sample: a frame in binary mode, a CSV line while
+ * streaming in text mode, nothing otherwise
+ */
+void telemetry_send_sample(const sensor_sample_t* sample)
+{
+    if (mode == TELEMETRY_BINARY || streaming)
+    {
+        write_sample(sample);
+    }
+}
+
+/**
+ * @brief start sending the most recent history entries, oldest first
+ *
+ * @details The entries are sent in chunks by telemetry_dump_step(), so
+ * acquisition and the UI keep running during a long dump. Starting a new
+ * dump replaces one still in progress.
+ *
+ * @param n entries wanted
+ *
+ * @return entries that will be sent (n capped to what is held)
+ */
+size_t telemetry_dump_history(size_t n)
+{
+    size_t count = history_count();
+    if (n > count)
+    {
+        n = count;
+    }
+
+    dump_end = history_head();
+    dump_next = dump_end - (uint32_t)n;
+    dump_skipped = 0;
+    dump_flash = false;
+    dumping = true;
+    event_post(EVENT_HISTORY);
+    return n;
+}
+
+/**
+ * @brief start sending the samples of the most recent flash pages, oldest first
+ *
+ * @details Shares the chunked dump of telemetry_dump_history(), and
+ * replaces a dump still in progress. Samples still buffered in RAM are
+ * not included; they are in the RAM history.
+ *
+ * @param pages pages wanted
+ *
+ * @return pages that will be sent (pages capped to what is held)
+ */
+size_t telemetry_dump_flash(size_t pages)
+{
+    uint32_t first;
+    uint32_t next;
+
+    flash_store_page_range(&first, &next);
+    if (pages > next - first)
+    {
+        pages = next - first;
+    }
+
+    dump_end = next;
+    dump_next = next - (uint32_t)pages;
+    dump_skipped = 0;
+    page_left = 0;
+    dump_flash = true;
+    dumping = true;
+    event_post(EVENT_HISTORY);
+    return pages;
+}
+
+/**
+ * @brief next history entry of the dump
+ *
+ * @return false if the entry was lapped by new samples; the dump then
+ * resumes at the oldest entry still held
+ */
+static bool history_dump_next(sensor_sample_t* sample)
+{
+    if (!history_get(dump_next, sample))
+    {
+        uint32_t oldest = history_head() - (uint32_t)history_count();
+        uint32_t resume = ((int32_t)(oldest - dump_end) >= 0) ? dump_end : oldest;
+        dump_skipped += resume - dump_next;
+        dump_next = resume;
+        return false;
+    }
+
+    dump_next++;
+    return true;
+}
+
+/**
+ * @brief next sample of the flash dump, opening the next page as needed
+ *
+ * @return false if a page was skipped: erased by the log wrapping round,
+ * cut short by power loss or failing its CRC
+ */
+static bool flash_dump_next(sensor_sample_t* sample)
+{
+    if (page_left == 0)
+    {
+        if (!flash_store_open_page(dump_next++, &page_decoder, &page_left))
+        {
+            dump_skipped++;
+            return false;
+        }
+    }
+
+    if (!codec_decode(&page_decoder, sample))
+    {
+        page_left = 0;
+        return false;
+    }
+    page_left--;
+    return true;
+}
+
+/**
+ * @brief queue the next chunk of a history or flash dump (EVENT_HISTORY task)
+ *
+ * @details Stops early when the TX ring is short of room and asks the
+ * ring to post EVENT_HISTORY again once the drain has made space.
+ *
+ * @return true if entries are left and the ring still has room
+ */
+bool telemetry_dump_step(void)
+{
+    if (!dumping)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < HISTORY_CHUNK && (dump_next != dump_end || page_left > 0); i++)
+    {
+        if (usb_tx_free() < SAMPLE_RECORD_MAX)
+        {
+            usb_tx_notify_space(EVENT_HISTORY);
+            return false;
+        }
+
+        sensor_sample_t sample;
+        if (dump_flash ? flash_dump_next(&sample) : history_dump_next(&sample))
+        {
+            write_sample(&sample);
+        }
+    }
+
+    if (dump_next != dump_end || page_left > 0)
+    {
+        return true;
+    }
+
+    dumping = false;
+    if (mode != TELEMETRY_BINARY)
+    {
+        char line[40];
+        int len = dump_flash
+            ? snprintf(line, sizeof(line), "# flash end, %lu pages skipped\n",
+                       (unsigned long)dump_skipped)
+            : snprintf(line, sizeof(line), "# history end, %lu overwritten\n",
+                       (unsigned long)dump_skipped);
+        usb_tx_write(line, (size_t)len);
+    }
+    return false;
+}
+
+/**
+ * @brief acknowledge a command (binary mode only)
+ *
+ * @param command command name as typed
+ * @param ok true if the command was accepted and run
+ */
+void telemetry_send_ack(const char* command, bool ok)
+{
+    if (mode != TELEMETRY_BINARY)
+    {
+        return;
+    }
+
+    telemetry_ack_msg_t msg = { .ok = ok };
+    strncpy(msg.command, command, sizeof(msg.command));
+    telemetry_send(MSG_ACK, &msg, sizeof(msg));
+}
+
+/**
+ * @brief report new alarm events: an ALARM frame in binary mode, a
+ * "# alarm" line in text mode
+ *
+ * @details Events that do not fit in the TX ring stay queued for the next
+ * call
+ */
+void telemetry_send_alarms(void)
+{
+    alarm_event_t ev;
+
+    while (usb_tx_free() >= SAMPLE_RECORD_MAX && alarm_event_read(&alarm_cursor, &ev))
+    {
+        if (mode == TELEMETRY_BINARY)
+        {
+            telemetry_alarm_msg_t msg = {
+                .timestamp_ms = ev.timestamp_ms,
+                .rule = ev.rule,
+                .channel = ev.channel,
+                .kind = ev.kind,
+                .fired = ev.fired,
+                .value = ev.value,
+            };
+            telemetry_send(MSG_ALARM, &msg, sizeof(msg));
+            continue;
+        }
+
+        char value[12];
+        char line[SAMPLE_RECORD_MAX];
+        fixed_format_hundredths(value, sizeof(value), ev.value);
+        int len = snprintf(line, sizeof(line), "# alarm %u %s: %s %s %s at %lu ms\n",
+                           ev.rule, ev.fired ? "fired" : "cleared",
+                           alarm_channel_name(ev.channel), alarm_kind_name(ev.kind),
+                           value, (unsigned long)ev.timestamp_ms);
+        usb_tx_write(line, (size_t)len);
+    }
+}
@@ -0,0 +1,110 @@
+/**
+ * @file telemetry.h
+ * @brief Binary framed telemetry on the USB CDC link
+ *
+ * Frame (before encoding):
+ *   | type u8 | seq u8 | payload (little-endian) | crc16 u16 LE |
+ *
+ * The CRC is CRC-16/CCITT-FALSE over type, seq and payload. The frame is
+ * COBS encoded and sent between two 0x00 delimiters, so a decoder can
+ * resync at any zero byte and text that slips in between frames fails
+ * the CRC instead of corrupting a frame.
+ *
+ * Frames and streamed CSV lines are queued on the USB TX ring (usb_tx.h)
+ * and never block the caller.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../app/sample_queue.h"
+
+#define TELEMETRY_MAX_PAYLOAD 48
+
+// Message types
+typedef enum
+{
+    MSG_SAMPLE = 0x01,   // telemetry_sample_msg_t
+    MSG_STATS = 0x02,    // telemetry_stats_msg_t
+    MSG_CONFIG = 0x03,   // telemetry_config_msg_t
+    MSG_ACK = 0x04,      // telemetry_ack_msg_t
+    MSG_SAMPLE_DERIVED = 0x05,  // telemetry_derived_msg_t, replaces MSG_SAMPLE when fields are selected
+    MSG_ALARM = 0x06,    // telemetry_alarm_msg_t
+} telemetry_msg_type_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t timestamp_ms;
+    int32_t temp;        // centi-degrees celsius
+    int32_t humidity;    // centi-percent
+} telemetry_sample_msg_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t timestamp_ms;
+    int32_t temp;           // centi-degrees celsius
+    int32_t humidity;       // centi-percent
+    uint8_t fields;         // psychro_metric_t bits; unselected values are 0
+    int32_t dew_point;      // centi-degrees celsius
+    int32_t heat_index;     // centi-degrees celsius
+    int32_t abs_humidity;   // centi-g/m3
+} telemetry_derived_msg_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t samples;
+    uint32_t retries;
+    uint32_t failures;
+    uint32_t i2c_errors;
+    uint32_t crc_errors;
+    uint32_t busy_errors;
+    uint32_t cal_errors;
+    uint32_t queue_overflows;
+    uint32_t tx_overruns;
+} telemetry_stats_msg_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t temp_unit;   // 0 = C, 1 = F
+    uint8_t led_pattern;
+    uint8_t mock;
+} telemetry_config_msg_t;
+
+typedef struct __attribute__((packed))
+{
+    uint8_t ok;          // 1 if the command was accepted
+    char command[15];    // command name, NUL padded
+} telemetry_ack_msg_t;
+
+typedef struct __attribute__((packed))
+{
+    uint32_t timestamp_ms;
+    uint8_t rule;           // rule index
+    uint8_t channel;        // alarm_channel_t
+    uint8_t kind;           // alarm_kind_t
+    uint8_t fired;          // 1 fired, 0 cleared
+    int32_t value;          // centi-units, or centi-units per minute for rise/fall
+} telemetry_alarm_msg_t;
+
+// Session output mode
+typedef enum
+{
+    TELEMETRY_TEXT,
+    TELEMETRY_BINARY
+} telemetry_mode_t;
+
+void telemetry_set_mode(telemetry_mode_t mode);
+bool telemetry_binary(void);
+void telemetry_set_stream(bool on);
+bool telemetry_streaming(void);
+void telemetry_set_fields(uint8_t fields);
+uint8_t telemetry_fields(void);
+bool telemetry_send(telemetry_msg_type_t type, const void* payload, size_t len);
+void telemetry_send_sample(const sensor_sample_t* sample);
+void telemetry_send_ack(const char* command, bool ok);
+size_t telemetry_dump_history(size_t n);
+size_t telemetry_dump_flash(size_t pages);
+bool telemetry_dump_step(void);
+void telemetry_send_alarms(void);
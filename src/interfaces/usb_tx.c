@@ -0,0 +1,225 @@
+/**
+ * @file usb_tx.c
+ * @brief Non-blocking USB CDC output through a TX ring buffer
+ */
+
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "usb_tx.h"
+
+_Static_assert((USB_TX_RING_SIZE & (USB_TX_RING_SIZE - 1)) == 0,
+               "USB_TX_RING_SIZE must be a power of two");
+
+_Static_assert((USB_TX_MAX_RECORDS & (USB_TX_MAX_RECORDS - 1)) == 0,
+               "USB_TX_MAX_RECORDS must be a power of two");
+
+#define RING_MASK (USB_TX_RING_SIZE - 1)
+#define RECORD_MASK (USB_TX_MAX_RECORDS - 1)
+
+static uint8_t ring[USB_TX_RING_SIZE];
+static uint32_t head = 0;   // next byte to write (free-running)
+static uint32_t tail = 0;   // next byte to send (free-running)
+
+// end offset (free-running, like head) of every record not fully sent
+static uint32_t record_ends[USB_TX_MAX_RECORDS];
+static uint32_t record_head = 0;
+static uint32_t record_tail = 0;
+static bool retry_armed = false;
+static bool space_wanted = false;
+static event_type_t space_event;
+static usb_tx_stats_t stats;
+
+/**
+ * @brief one-shot alarm: the endpoint was full, try draining again
+ */
+static int64_t retry_callback(alarm_id_t id, void* user_data)
+{
+    retry_armed = false;
+    event_post(EVENT_TX_READY);
+    return 0;
+}
+
+/**
+ * @brief count a record that could not be queued
+ */
+static bool drop(size_t len)
+{
+    stats.records_dropped++;
+    stats.bytes_dropped += (uint32_t)len;
+    return false;
+}
+
+/**
+ * @brief queue one record for transmission without blocking
+ *
+ * @param data record bytes, ending in '\n' (text) or 0x00 (frame)
+ * @param len record length
+ *
+ * @return true if queued, false if dropped (overrun or no host)
+ */
+bool usb_tx_write(const void* data, size_t len)
+{
+    uint32_t used = head - tail;
+
+    if (!tud_cdc_connected())
+    {
+        return drop(len);
+    }
+
+    if (len > USB_TX_RING_SIZE - used || record_head - record_tail == USB_TX_MAX_RECORDS)
+    {
+        return drop(len);
+    }
+
+    // copy in up to two pieces around the wrap
+    uint32_t offset = head & RING_MASK;
+    size_t first = USB_TX_RING_SIZE - offset;
+    if (first > len)
+    {
+        first = len;
+    }
+    memcpy(&ring[offset], data, first);
+    memcpy(ring, (const uint8_t*)data + first, len - first);
+    head += (uint32_t)len;
+    record_ends[record_head & RECORD_MASK] = head;
+    record_head++;
+
+    if (head - tail > stats.high_water)
+    {
+        stats.high_water = head - tail;
+    }
+
+    event_post(EVENT_TX_READY);
+    return true;
+}
+
+/**
+ * @brief wake a producer waiting for room, see usb_tx_notify_space()
+ */
+static void space_freed(void)
+{
+    if (space_wanted)
+    {
+        space_wanted = false;
+        event_post(space_event);
+    }
+}
+
+/**
+ * @brief length of the longest prefix of n bytes that ends on a record
+ * boundary; the records in it are retired
+ *
+ * @details Boundaries come from the record ends noted by usb_tx_write(),
+ * not from the bytes, since a COBS frame may contain '\n'
+ */
+static uint32_t record_prefix(uint32_t n)
+{
+    uint32_t end = tail;
+
+    while (record_tail != record_head && record_ends[record_tail & RECORD_MASK] - tail <= n)
+    {
+        end = record_ends[record_tail & RECORD_MASK];
+        record_tail++;
+    }
+    return end - tail;
+}
+
+/**
+ * @brief send as much buffered output as the CDC endpoint accepts now
+ *
+ * @details Never waits for the host. If output remains, a short alarm
+ * posts EVENT_TX_READY again rather than spinning the scheduler.
+ *
+ * @return true if output is still buffered
+ */
+bool usb_tx_drain(void)
+{
+    uint32_t used = head - tail;
+
+    if (used == 0)
+    {
+        return false;
+    }
+
+    if (!tud_cdc_connected())
+    {
+        // host went away: buffered records are stale, count them as lost
+        stats.records_dropped++;
+        stats.bytes_dropped += used;
+        tail = head;
+        record_tail = record_head;
+        space_freed();
+        return false;
+    }
+
+    uint32_t n = tud_cdc_write_available();
+    if (n > used)
+    {
+        n = used;
+    }
+    n = record_prefix(n);
+
+    // stdio does not block while the write fits in the endpoint buffer
+    while (n > 0)
+    {
+        uint32_t offset = tail & RING_MASK;
+        uint32_t chunk = USB_TX_RING_SIZE - offset;
+        if (chunk > n)
+        {
+            chunk = n;
+        }
+        stdio_put_string((const char*)&ring[offset], (int)chunk, false, false);
+        tail += chunk;
+        stats.bytes_sent += chunk;
+        n -= chunk;
+    }
+
+    if (head - tail < used)
+    {
+        space_freed();
+    }
+
+    if (head != tail && !retry_armed)
+    {
+        // no free alarm slot: the next write or drain tries again
+        retry_armed = add_alarm_in_ms(USB_TX_RETRY_MS, retry_callback, NULL, true) > 0;
+    }
+
+    return head != tail;
+}
+
+/**
+ * @brief bytes waiting to be sent
+ */
+size_t usb_tx_pending(void)
+{
+    return head - tail;
+}
+
+/**
+ * @brief bytes that can be queued right now
+ */
+size_t usb_tx_free(void)
+{
+    return USB_TX_RING_SIZE - (head - tail);
+}
+
+/**
+ * @brief post an event the next time the drain frees some space
+ *
+ * @param event event to post once; a later call replaces it
+ */
+void usb_tx_notify_space(event_type_t event)
+{
+    space_event = event;
+    space_wanted = true;
+}
+
+/**
+ * @brief TX ring counters
+ */
+const usb_tx_stats_t* usb_tx_get_stats(void)
+{
+    return &stats;
+}
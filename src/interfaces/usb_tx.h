@@ -0,0 +1,46 @@
+/**
+ * @file usb_tx.h
+ * @brief Non-blocking USB CDC output through a TX ring buffer
+ *
+ * Producers append whole records (a CSV line or a telemetry frame) and
+ * never wait: if the ring has no room, or no host is connected, the record
+ * is dropped and counted as an overrun. The ring keeps the end offset of
+ * every record it accepts. The TX task drains only as far as the CDC
+ * endpoint has space, and only up to the end of the last whole record, so
+ * text printed by commands never lands in the middle of a record, even
+ * when a frame's payload contains a '\n' byte.
+ *
+ * A bulk producer that finds the ring full can ask for an event to be
+ * posted once the drain has made room (usb_tx_notify_space) instead of
+ * dropping records or polling.
+ *
+ * All producers and the drain run in scheduler context on core0, so the
+ * ring needs no locking.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "../app/events.h"
+
+#define USB_TX_RING_SIZE 2048   // must be a power of two
+#define USB_TX_MAX_RECORDS 128  // records queued at once; must be a power of two
+#define USB_TX_RETRY_MS 2       // re-check a full CDC endpoint this often
+
+// TX ring counters
+typedef struct
+{
+    uint32_t bytes_sent;        // bytes handed to the CDC endpoint
+    uint32_t records_dropped;   // overruns: records rejected whole
+    uint32_t bytes_dropped;     // bytes in those records
+    uint32_t high_water;        // most bytes ever buffered
+} usb_tx_stats_t;
+
+bool usb_tx_write(const void* data, size_t len);
+bool usb_tx_drain(void);
+size_t usb_tx_pending(void);
+size_t usb_tx_free(void);
+void usb_tx_notify_space(event_type_t event);
+const usb_tx_stats_t* usb_tx_get_stats(void);
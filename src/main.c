@@ -2,20 +2,181 @@
 #include "pico/stdlib.h"
 #include "hardware/i2c.h"
 #include "drivers/dht20.h"
+#include "drivers/i2c_bus.h"
 #include "interfaces/command_interface.h"
-#include "interfaces/commands.h"
+#include "interfaces/telemetry.h"
+#include "interfaces/usb_tx.h"
 #include "drivers/lcd_pcf8574.h"
 #include "app/ui.h"
 #include "app/sensor_task.h"
+#include "app/events.h"
+#include "app/scheduler.h"
+#include "app/sample_history.h"
+#include "app/flash_store.h"
+#include "app/rrd.h"
+#include "app/rolling_stats.h"
+#include "app/alarm.h"
+#include "app/led_anim.h"
 
 #define SDA_PIN 4
 #define SCL_PIN 5
 #define SENSOR_TIMEOUT_US 1500000
+#define SAMPLE_DRAIN_BATCH 8
+#define LOG_QUEUE_SIZE 32   // samples waiting for the logging task
+
+// Task deadlines (release to completion)
+#define CMD_DEADLINE_US 1000
+#define SENSOR_DEADLINE_US 2000
+#define UI_DEADLINE_US 50000
+#define TX_DEADLINE_US 500
+#define LOG_DEADLINE_US 100000   // a flash sector erase takes tens of ms
+#define HISTORY_DEADLINE_US 2000
+#define WATCHDOG_DEADLINE_US 1000
+#define ANIM_DEADLINE_US 5000
 
-static bool sensor_data_ready = false;
-static struct repeating_timer sensor_timer;
 volatile absolute_time_t prev_time;
 
+// Samples handed from the UI task to the logging task; both run on core0
+static sensor_sample_t log_queue[LOG_QUEUE_SIZE];
+static uint32_t log_head = 0;
+static uint32_t log_tail = 0;
+
+/**
+ * @brief command task (EVENT_USB_RX): run pending serial commands
+ *
+ * @return true while input may remain (the RX callback only fires on new data)
+ */
+static bool task_commands(void)
+{
+    return cmd_process();
+}
+
+#if !SENSOR_MULTICORE
+/**
+ * @brief sensor task (EVENT_SENSOR_STEP): acquisition step, queues finished samples
+ */
+static bool task_sensor(void)
+{
+    sensor_task_poll();
+    return false;
+}
+#endif
+
+/**
+ * @brief logging task (EVENT_LOG): record queued samples in the RAM
+ * history and the flash store
+ *
+ * @details Kept out of the UI task because a flash page program, and
+ * every 15th page a sector erase, stalls for milliseconds
+ *
+ * @return true while samples remain queued
+ */
+static bool task_log(void)
+{
+    for (uint8_t i = 0; i < SAMPLE_DRAIN_BATCH && log_tail != log_head; i++)
+    {
+        const sensor_sample_t* sample = &log_queue[log_tail % LOG_QUEUE_SIZE];
+        history_push(sample);
+        flash_store_append(sample);
+        log_tail++;
+    }
+    return log_tail != log_head;
+}
+
+/**
+ * @brief queue a sample for the logging task
+ *
+ * @details If the logging task has fallen a whole queue behind, the
+ * oldest entries are logged here so no sample is lost
+ */
+static void log_sample(const sensor_sample_t* sample)
+{
+    while (log_head - log_tail >= LOG_QUEUE_SIZE)
+    {
+        task_log();
+    }
+    log_queue[log_head % LOG_QUEUE_SIZE] = *sample;
+    log_head++;
+    event_post(EVENT_LOG);
+}
+
+/**
+ * @brief UI task (EVENT_SAMPLE_READY): drain the sample queue, process and
+ * forward every sample, queue it for logging, and update the UI
+ *
+ * @return true if the queue may still hold samples
+ */
+static bool task_ui(void)
+{
+    sensor_sample_t samples[SAMPLE_DRAIN_BATCH];
+    size_t count = read_sensor_data(samples, SAMPLE_DRAIN_BATCH);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        log_sample(&samples[i]);
+        rrd_add(&samples[i]);
+        rolling_stats_add(&samples[i]);
+        alarm_evaluate(&samples[i]);
+        telemetry_send_sample(&samples[i]);
+    }
+
+    telemetry_send_alarms();
+
+    if (count > 0)
+    {
+        // UI only needs the newest sample of the batch
+        const sensor_sample_t* latest = &samples[count - 1];
+        ui_update(latest->humidity, convert_temp(latest->temp), get_unit_symbol()); // Third param is to pass unit symbol (e.g. 'C' or 'F')
+        prev_time = get_absolute_time();
+    }
+
+    return count == SAMPLE_DRAIN_BATCH; // more may be queued
+}
+
+/**
+ * @brief TX task (EVENT_TX_READY): hand buffered output to the USB endpoint
+ *
+ * @return false: if the endpoint is full, the ring re-posts its event from
+ * a short alarm instead of keeping the scheduler busy
+ */
+static bool task_tx(void)
+{
+    usb_tx_drain();
+    return false;
+}
+
+/**
+ * @brief history task (EVENT_HISTORY): queue the next chunk of a dump
+ *
+ * @return true while entries remain and the TX ring has room
+ */
+static bool task_history(void)
+{
+    return telemetry_dump_step();
+}
+
+/**
+ * @brief animation task (periodic, LED_ANIM_FPS): render the next LED frame
+ */
+static bool task_anim(void)
+{
+    led_anim_render();
+    return false;
+}
+
+/**
+ * @brief watchdog task (periodic): error check sensor irq
+ */
+static bool task_watchdog(void)
+{
+    int64_t diff_us = absolute_time_diff_us(prev_time, get_absolute_time());
+    if (diff_us > SENSOR_TIMEOUT_US)
+    {
+        printf("Timer stalled\n");
+    }
+    return false;
+}
+
 int main()
 {
     stdio_init_all();
@@ -28,44 +189,45 @@ int main()
         sleep_ms(10);
     }
 
-    // I2C setup
-    i2c_init(i2c0, 100 * 1000);
-    gpio_set_function(SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(SDA_PIN);
-    gpio_pull_up(SCL_PIN);
+    // I2C setup (bus shared by LCD and DHT20)
+    i2c_bus_init(i2c0, 100 * 1000, SDA_PIN, SCL_PIN);
 
     // app setup
     dht20_init();
+    if (!flash_store_init(&flash_backend_rp2040))
+    {
+        printf("Flash store region invalid\n");
+    }
+    alarm_init();
     cmd_init();
-    commands_init();
     init_sensor_task();
     ui_init();
     ui_startup();
 
     sleep_ms(1200);
 
-    while (true)
-    {
-        // Check for serial commands (non-blocking)
-        cmd_process();
-
-        // error check sensor irq
-        int64_t diff_us = absolute_time_diff_us(prev_time, get_absolute_time());
-        if (diff_us > SENSOR_TIMEOUT_US)
-        {
-            printf("Timer stalled\n");
-        }
-
-        float humidity, temp;
-        char unit;
-
-        if(read_sensor_data(&temp, &humidity, &unit))
-        {
-            ui_update(humidity, temp, unit); // Third param is to pass unit symbol (e.g. 'C' or 'F')
-            prev_time = get_absolute_time();
-        }
-
-        sleep_ms(1);
-    }
+#if SENSOR_MULTICORE
+    // core1 takes over sensor acquisition; core0 keeps commands and UI
+    sensor_task_launch_core1();
+#endif
+
+    // tasks, in priority order
+    sched_add_event("cmd", task_commands, EVENT_USB_RX, CMD_DEADLINE_US);
+#if !SENSOR_MULTICORE
+    sched_add_event("sensor", task_sensor, EVENT_SENSOR_STEP, SENSOR_DEADLINE_US);
+#endif
+    sched_add_event("ui", task_ui, EVENT_SAMPLE_READY, UI_DEADLINE_US);
+    sched_add_event("tx", task_tx, EVENT_TX_READY, TX_DEADLINE_US);
+    sched_add_event("log", task_log, EVENT_LOG, LOG_DEADLINE_US);
+    sched_add_event("history", task_history, EVENT_HISTORY, HISTORY_DEADLINE_US);
+    sched_add_periodic("anim", task_anim, LED_ANIM_FRAME_US, ANIM_DEADLINE_US);
+    sched_add_periodic("watchdog", task_watchdog, SENSOR_TIMEOUT_US, WATCHDOG_DEADLINE_US);
+
+    prev_time = get_absolute_time();
+
+    // input that arrived during startup did not fire the RX callback yet
+    event_post(EVENT_USB_RX);
+
+    // sleeps until a timer, USB RX or sample-ready event is pending
+    sched_run();
 }
@@ -0,0 +1,19 @@
+/**
+ * @file stdlib.h
+ * @brief Host stand-in for the Pico SDK calls used by the modules under test
+ *
+ * Only declarations; each test defines the ones its module needs and
+ * records or scripts their behaviour.
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void* user_data);
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void* user_data, bool fire_if_past);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void* user_data, bool fire_if_past);
+void stdio_put_string(const char* s, int len, bool newline, bool cr_translation);
@@ -0,0 +1,12 @@
+/**
+ * @file tusb.h
+ * @brief Host stand-in for the TinyUSB CDC calls used by usb_tx.c
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+bool tud_cdc_connected(void);
+uint32_t tud_cdc_write_available(void);
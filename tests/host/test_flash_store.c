@@ -0,0 +1,350 @@
+/**
+ * @file test_flash_store.c
+ * @brief Host test and benchmark of the flash sample store
+ *
+ * Runs flash_store.c against flash_backend_file.c (append, reboot scan,
+ * torn and corrupted pages) and against a RAM NOR image (sector wrap,
+ * erase rotation and throughput, free of file I/O).
+ *
+ * Usage: test_flash_store <image file>
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "flash_store.h"
+
+#define SAMPLE_PERIOD_MS 1000
+#define BENCH_SAMPLES 1000000
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+// RAM image with NOR semantics, for the wrap test and the benchmark
+#define RAM_SECTORS 4
+static uint8_t ram_image[RAM_SECTORS * FLASH_STORE_SECTOR_SIZE];
+
+static bool ram_read(uint32_t offset, void* buf, size_t len)
+{
+    if (offset + len > sizeof(ram_image))
+    {
+        return false;
+    }
+    memcpy(buf, &ram_image[offset], len);
+    return true;
+}
+
+static bool ram_erase_sector(uint32_t offset)
+{
+    memset(&ram_image[offset], 0xFF, FLASH_STORE_SECTOR_SIZE);
+    return true;
+}
+
+static bool ram_program_page(uint32_t offset, const void* page)
+{
+    const uint8_t* data = page;
+    for (size_t i = 0; i < FLASH_STORE_PAGE_SIZE; i++)
+    {
+        ram_image[offset + i] &= data[i];
+    }
+    return true;
+}
+
+static const flash_backend_t ram_backend = {
+    .size = sizeof(ram_image),
+    .read = ram_read,
+    .erase_sector = ram_erase_sector,
+    .program_page = ram_program_page,
+};
+
+/**
+ * @brief sample n of a sensor-like series: 1 Hz, slow drift plus noise
+ */
+static sensor_sample_t make_sample(uint32_t n)
+{
+    sensor_sample_t sample = {
+        .timestamp_ms = n * SAMPLE_PERIOD_MS,
+        .temp = 2200 + (int32_t)(n / 97 % 40) + (int32_t)(n * 7 % 5),
+        .humidity = 4500 + (int32_t)(n / 131 % 60) + (int32_t)(n * 3 % 7),
+    };
+    return sample;
+}
+
+/**
+ * @brief region offset of a data page, as laid out in flash_store.h
+ */
+static uint32_t page_offset(uint32_t page_seq, uint32_t sectors)
+{
+    uint32_t sector = (page_seq / STORE_DATA_PAGES) % sectors;
+    return sector * FLASH_STORE_SECTOR_SIZE + (1 + page_seq % STORE_DATA_PAGES) * FLASH_STORE_PAGE_SIZE;
+}
+
+/**
+ * @brief decode every readable page and check the samples follow the series
+ *
+ * @param bad_pages location to store the number of unreadable pages
+ *
+ * @return samples read back
+ */
+static uint32_t read_back(uint32_t* bad_pages)
+{
+    uint32_t first;
+    uint32_t next;
+    uint32_t samples = 0;
+    bool have_prev = false;
+    uint32_t prev_n = 0;
+
+    *bad_pages = 0;
+    flash_store_page_range(&first, &next);
+    for (uint32_t seq = first; seq != next; seq++)
+    {
+        codec_decoder_t decoder;
+        uint16_t count;
+        if (!flash_store_open_page(seq, &decoder, &count))
+        {
+            (*bad_pages)++;
+            have_prev = false;
+            continue;
+        }
+
+        for (uint16_t i = 0; i < count; i++)
+        {
+            sensor_sample_t sample;
+            if (!codec_decode(&decoder, &sample))
+            {
+                CHECK(false);
+                break;
+            }
+
+            uint32_t n = sample.timestamp_ms / SAMPLE_PERIOD_MS;
+            sensor_sample_t expected = make_sample(n);
+            CHECK(sample.temp == expected.temp && sample.humidity == expected.humidity);
+            CHECK(!have_prev || n == prev_n + 1);
+            prev_n = n;
+            have_prev = true;
+            samples++;
+        }
+    }
+    return samples;
+}
+
+/**
+ * @brief append and flush, then rescan the image as after a reboot
+ */
+static void test_append_and_reboot(const flash_backend_t* flash)
+{
+    uint32_t first;
+    uint32_t next;
+    uint32_t bad;
+
+    CHECK(flash_store_init(flash));
+    flash_store_page_range(&first, &next);
+    CHECK(first == 0 && next == 0);
+
+    for (uint32_t n = 0; n < 2000; n++)
+    {
+        sensor_sample_t sample = make_sample(n);
+        CHECK(flash_store_append(&sample));
+    }
+    uint32_t buffered = (uint32_t)flash_store_buffered();
+    CHECK(buffered > 0);
+    CHECK(read_back(&bad) == 2000 - buffered && bad == 0);
+
+    CHECK(flash_store_flush());
+    CHECK(flash_store_buffered() == 0);
+    flash_store_page_range(&first, &next);
+    uint32_t pages = next;
+
+    // a reboot loses nothing that was flushed and appends after it
+    CHECK(flash_store_init(flash));
+    flash_store_page_range(&first, &next);
+    CHECK(next == pages);
+    CHECK(read_back(&bad) == 2000 && bad == 0);
+
+    for (uint32_t n = 2000; n < 2500; n++)
+    {
+        sensor_sample_t sample = make_sample(n);
+        CHECK(flash_store_append(&sample));
+    }
+    CHECK(flash_store_flush());
+    CHECK(read_back(&bad) == 2500 && bad == 0);
+    flash_store_page_range(&first, &next);
+    printf("append/reboot: 2500 samples in %lu pages\n", (unsigned long)(next - first));
+}
+
+/**
+ * @brief a page cut short by power loss, and one with a flipped bit
+ */
+static void test_torn_pages(const flash_backend_t* flash, uint32_t sectors)
+{
+    uint8_t page[FLASH_STORE_PAGE_SIZE];
+    uint32_t first;
+    uint32_t next;
+    uint32_t bad;
+    flash_store_stats_t stats;
+
+    // torn write at the head: only the first half of the page reached flash
+    flash_store_page_range(&first, &next);
+    memset(page, 0xFF, sizeof(page));
+    memset(page, 0x5A, sizeof(page) / 2);
+    CHECK(flash->program_page(page_offset(next, sectors), page));
+
+    // the reboot scan counts the torn page as used and resumes after it
+    CHECK(flash_store_init(flash));
+    uint32_t torn = next;
+    flash_store_page_range(&first, &next);
+    CHECK(next == torn + 1);
+
+    uint32_t samples = read_back(&bad);
+    CHECK(samples == 2500 && bad == 1);
+
+    for (uint32_t n = 2500; n < 2600; n++)
+    {
+        sensor_sample_t sample = make_sample(n);
+        CHECK(flash_store_append(&sample));
+    }
+    CHECK(flash_store_flush());
+
+    // clear one set bit in the payload of an earlier, committed page
+    CHECK(flash->read(page_offset(1, sectors), page, sizeof(page)));
+    size_t at = STORE_PAGE_HEADER_SIZE;
+    while (at < STORE_PAGE_HEADER_SIZE + STORE_PAGE_PAYLOAD && page[at] == 0)
+    {
+        at++;
+    }
+    uint8_t cleared = (uint8_t)(page[at] & (page[at] - 1));
+    memset(page, 0xFF, sizeof(page));
+    page[at] = cleared;
+    CHECK(flash->program_page(page_offset(1, sectors), page));
+
+    flash_store_get_stats(&stats);
+    uint32_t crc_errors = stats.crc_errors;
+    samples = read_back(&bad);
+    flash_store_get_stats(&stats);
+    CHECK(bad == 2);
+    CHECK(stats.crc_errors - crc_errors == 2);
+    CHECK(samples > 2000 && samples < 2600);
+    printf("torn pages: %lu samples readable, %lu pages skipped\n",
+           (unsigned long)samples, (unsigned long)bad);
+}
+
+/**
+ * @brief wrap the log several times round a small region
+ */
+static void test_wrap(void)
+{
+    uint32_t first;
+    uint32_t next;
+    uint32_t bad;
+    flash_store_stats_t stats;
+
+    memset(ram_image, 0xFF, sizeof(ram_image));
+    CHECK(flash_store_init(&ram_backend));
+
+    uint32_t n = 0;
+    for (; n < 60000; n++)
+    {
+        sensor_sample_t sample = make_sample(n);
+        CHECK(flash_store_append(&sample));
+    }
+
+    flash_store_page_range(&first, &next);
+    flash_store_get_stats(&stats);
+    CHECK(next > 5 * RAM_SECTORS * STORE_DATA_PAGES);
+    CHECK(next - first <= RAM_SECTORS * STORE_DATA_PAGES);
+    CHECK(next - first >= (RAM_SECTORS - 1) * STORE_DATA_PAGES);
+    CHECK(stats.max_erase_count - stats.min_erase_count <= 1);
+    CHECK(stats.write_errors == 0);
+
+    // the newest held samples are the last ones appended, minus the buffer
+    uint32_t samples = read_back(&bad);
+    CHECK(bad == 0 && samples > 0);
+
+    // a reboot after the wrap finds the same head
+    uint32_t old_next = next;
+    CHECK(flash_store_init(&ram_backend));
+    flash_store_page_range(&first, &next);
+    CHECK(next == old_next);
+
+    // an erased page does not decode as samples from the previous lap
+    CHECK(!flash_store_open_page(next, &(codec_decoder_t){ 0 }, &(uint16_t){ 0 }));
+    CHECK(first == 0 || !flash_store_open_page(first - 1, &(codec_decoder_t){ 0 }, &(uint16_t){ 0 }));
+
+    printf("wrap: %lu pages written, %lu held, erase counts %lu..%lu\n",
+           (unsigned long)next, (unsigned long)(next - first),
+           (unsigned long)stats.min_erase_count, (unsigned long)stats.max_erase_count);
+}
+
+static double seconds_since(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/**
+ * @brief append and read-back throughput against the RAM image
+ */
+static void bench(void)
+{
+    struct timespec start;
+    flash_store_stats_t stats;
+    uint32_t bad;
+
+    memset(ram_image, 0xFF, sizeof(ram_image));
+    CHECK(flash_store_init(&ram_backend));
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t n = 0; n < BENCH_SAMPLES; n++)
+    {
+        sensor_sample_t sample = make_sample(n);
+        flash_store_append(&sample);
+    }
+    double append_s = seconds_since(&start);
+    flash_store_get_stats(&stats);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    uint32_t samples = read_back(&bad);
+    double read_s = seconds_since(&start);
+
+    printf("bench: append %.0f ns/sample (%lu pages, %.1f samples/page), read %.0f ns/sample\n",
+           append_s * 1e9 / BENCH_SAMPLES,
+           (unsigned long)stats.pages_written,
+           (double)BENCH_SAMPLES / stats.pages_written,
+           samples ? read_s * 1e9 / samples : 0.0);
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        printf("usage: %s <image file>\n", argv[0]);
+        return 2;
+    }
+
+    uint32_t sectors = 8;
+    remove(argv[1]);
+    const flash_backend_t* flash = flash_backend_file_open(argv[1], sectors * FLASH_STORE_SECTOR_SIZE);
+    if (flash == NULL)
+    {
+        printf("cannot open %s\n", argv[1]);
+        return 2;
+    }
+
+    test_append_and_reboot(flash);
+    test_torn_pages(flash, sectors);
+    test_wrap();
+    bench();
+
+    printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
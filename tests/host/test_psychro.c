@@ -0,0 +1,136 @@
+/**
+ * @file test_psychro.c
+ * @brief Host test of the fixed-point psychrometrics against a libm reference
+ *
+ * Sweeps -40 to 80 C in 0.1 C steps and 0 to 100 %RH in 0.5 % steps and
+ * checks the error bounds documented in psychro.h. The reference uses the
+ * same Magnus constants as scripts/gen_svp_table.py and the NWS heat index
+ * algorithm in double precision.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include "psychro.h"
+
+#define MAGNUS_A 17.62
+#define MAGNUS_B 243.12
+#define MAGNUS_E0 611.2       // Pa at 0 C
+#define RV 461.5              // J/(kg K), water vapour
+#define DEW_POINT_MIN_C -60.0 // psychro.c clamps to its table minimum
+
+// bounds from psychro.h, in the output units
+#define DEW_POINT_BOUND_C 0.03
+#define HEAT_INDEX_BOUND_C 0.05
+#define ABS_HUMIDITY_BOUND_REL 0.0015
+#define ABS_HUMIDITY_ROUNDING 0.005   // half a centi-g/m3
+
+static double ref_svp_pa(double t)
+{
+    return MAGNUS_E0 * exp(MAGNUS_A * t / (MAGNUS_B + t));
+}
+
+static double ref_dew_point(double t, double rh)
+{
+    double gamma = log(rh / 100.0) + MAGNUS_A * t / (MAGNUS_B + t);
+    double dew = MAGNUS_B * gamma / (MAGNUS_A - gamma);
+    if (dew < DEW_POINT_MIN_C)
+        return DEW_POINT_MIN_C;
+    return (dew > t) ? t : dew;
+}
+
+static double ref_abs_humidity(double t, double rh)
+{
+    return ref_svp_pa(t) * rh / 100.0 / (RV * (t + 273.15)) * 1000.0;
+}
+
+/**
+ * @brief NWS heat index; the regression is held at 140 F as in psychro.c
+ */
+static double ref_heat_index(double t_c, double rh)
+{
+    double t = t_c * 9.0 / 5.0 + 32.0;
+    double simple = 0.5 * (t + 61.0 + (t - 68.0) * 1.2 + rh * 0.094);
+
+    if ((simple + t) / 2.0 < 80.0)
+    {
+        return (simple - 32.0) * 5.0 / 9.0;
+    }
+
+    double tr = (t > 140.0) ? 140.0 : t;
+    double hi = -42.379 + 2.04901523 * tr + 10.14333127 * rh
+              - 0.22475541 * tr * rh - 0.00683783 * tr * tr
+              - 0.05481717 * rh * rh + 0.00122874 * tr * tr * rh
+              + 0.00085282 * tr * rh * rh - 0.00000199 * tr * tr * rh * rh;
+
+    if (rh < 13.0 && t >= 80.0 && t <= 112.0)
+    {
+        hi -= ((13.0 - rh) / 4.0) * sqrt((17.0 - fabs(tr - 95.0)) / 17.0);
+    }
+    else if (rh > 85.0 && t >= 80.0 && t <= 87.0)
+    {
+        hi += ((rh - 85.0) / 10.0) * ((87.0 - tr) / 5.0);
+    }
+    return (hi - 32.0) * 5.0 / 9.0;
+}
+
+int main(void)
+{
+    double dew_max = 0.0;
+    double heat_max = 0.0;
+    double abs_max_rel = 0.0;
+    int failures = 0;
+
+    for (int32_t temp = -4000; temp <= 8000; temp += 10)
+    {
+        for (int32_t humidity = 0; humidity <= 10000; humidity += 50)
+        {
+            double t = temp / 100.0;
+            double rh = humidity / 100.0;
+
+            // below 1 %RH the dew point clamps to the table minimum
+            if (humidity >= 100)
+            {
+                double err = fabs(psychro_dew_point(temp, humidity) / 100.0 - ref_dew_point(t, rh));
+                if (err > dew_max)
+                    dew_max = err;
+                if (err > DEW_POINT_BOUND_C)
+                {
+                    printf("FAIL dew point %.2f C %.2f %%: error %.4f C\n", t, rh, err);
+                    failures++;
+                }
+            }
+
+            double heat_err = fabs(psychro_heat_index(temp, humidity) / 100.0 - ref_heat_index(t, rh));
+            if (heat_err > heat_max)
+                heat_max = heat_err;
+            if (heat_err > HEAT_INDEX_BOUND_C)
+            {
+                printf("FAIL heat index %.2f C %.2f %%: error %.4f C\n", t, rh, heat_err);
+                failures++;
+            }
+
+            double abs_ref = ref_abs_humidity(t, rh);
+            double abs_err = fabs(psychro_abs_humidity(temp, humidity) / 100.0 - abs_ref);
+            double excess = abs_err - ABS_HUMIDITY_ROUNDING;
+            if (abs_ref > 0.0 && excess / abs_ref > abs_max_rel)
+                abs_max_rel = excess / abs_ref;
+            if (excess > ABS_HUMIDITY_BOUND_REL * abs_ref)
+            {
+                printf("FAIL abs humidity %.2f C %.2f %%: error %.4f g/m3\n", t, rh, abs_err);
+                failures++;
+            }
+        }
+    }
+
+    // saturated air: the dew point equals the air temperature
+    if (psychro_dew_point(2500, 10000) != 2500)
+    {
+        printf("FAIL dew point at 100 %% is not the air temperature\n");
+        failures++;
+    }
+
+    printf("max error: dew point %.4f C, heat index %.4f C, abs humidity %.4f %% beyond rounding\n",
+           dew_max, heat_max, abs_max_rel * 100.0);
+    printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
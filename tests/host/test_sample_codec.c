@@ -0,0 +1,297 @@
+/**
+ * @file test_sample_codec.c
+ * @brief Host round-trip test and benchmark of the sample codec
+ *
+ * Round-trips timestamp wrap, jumps that need the 32-bit escape, a block
+ * filled to the last bit and blocks holding only their raw first sample,
+ * then measures compression and encode/decode cost on a synthetic 1 Hz
+ * series with sensor-like noise, in HISTORY_BLOCK_SIZE blocks.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "sample_codec.h"
+#include "sample_history.h"
+
+#define BENCH_SAMPLES 1000000
+#define MAX_BLOCK_SAMPLES 4096
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+static uint32_t rng_state = 0x2545F491u;
+
+/**
+ * @brief xorshift32, so every run sees the same series
+ */
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+/**
+ * @brief uniform integer in [-span, span]
+ */
+static int32_t noise(int32_t span)
+{
+    return (int32_t)(rng() % (uint32_t)(2 * span + 1)) - span;
+}
+
+static bool same(const sensor_sample_t* a, const sensor_sample_t* b)
+{
+    return a->timestamp_ms == b->timestamp_ms && a->temp == b->temp && a->humidity == b->humidity;
+}
+
+/**
+ * @brief encode samples into one block of the given size and decode them back
+ *
+ * @return samples that fitted in the block
+ */
+static size_t round_trip(const sensor_sample_t* in, size_t n, size_t block_size)
+{
+    static uint8_t block[1024];
+    codec_encoder_t enc;
+    codec_decoder_t dec;
+    size_t fitted = 0;
+
+    codec_encoder_init(&enc, block, block_size);
+    while (fitted < n && codec_encode(&enc, &in[fitted]))
+    {
+        fitted++;
+    }
+    CHECK(enc.count == fitted);
+    CHECK(codec_encoded_bytes(&enc) <= block_size);
+
+    codec_decoder_init(&dec, block, block_size);
+    for (size_t i = 0; i < fitted; i++)
+    {
+        sensor_sample_t out;
+        if (!codec_decode(&dec, &out) || !same(&out, &in[i]))
+        {
+            printf("  sample %zu: got %u/%d/%d, want %u/%d/%d\n", i,
+                   out.timestamp_ms, out.temp, out.humidity,
+                   in[i].timestamp_ms, in[i].temp, in[i].humidity);
+            CHECK(false);
+            break;
+        }
+    }
+    return fitted;
+}
+
+/**
+ * @brief timestamps that cross the 32-bit wrap, with jitter
+ */
+static void test_timestamp_wrap(void)
+{
+    sensor_sample_t in[64];
+    uint32_t ts = 0xFFFFFFFFu - 20500u;
+
+    for (size_t i = 0; i < 64; i++)
+    {
+        in[i] = (sensor_sample_t){ .timestamp_ms = ts, .temp = 2150, .humidity = 4800 };
+        ts += 1000 + (uint32_t)noise(3);
+    }
+    CHECK(in[63].timestamp_ms < in[0].timestamp_ms);
+    CHECK(round_trip(in, 64, 248) == 64);
+}
+
+/**
+ * @brief jumps too large for the 12-bit code, in every field
+ */
+static void test_large_jumps(void)
+{
+    sensor_sample_t in[] = {
+        { 0, -32768, 0 },
+        { 1000, 32767, 10000 },
+        { 3000000000u, -32768, -32768 },
+        { 3000001000u, 0, 32767 },
+        { 1000, 5, 5 },                  // back in time
+        { 0xFFFFFFFFu, -4096, 4095 },
+        { 0, 4096, -4097 },
+        { 0x80000000u, 2000, 4000 },
+        { 0x80000000u, 2000, 4000 },     // repeated timestamp
+        { 0x7FFFFFFFu, 2001, 3999 },
+    };
+    size_t n = sizeof(in) / sizeof(in[0]);
+
+    CHECK(round_trip(in, n, 248) == n);
+}
+
+/**
+ * @brief fill a block until a sample is refused; the refusal must not
+ * disturb what the block already holds
+ */
+static void test_full_block(void)
+{
+    static sensor_sample_t in[MAX_BLOCK_SAMPLES];
+    uint8_t block[64];
+    codec_encoder_t enc;
+
+    int32_t temp = 2200;
+    for (size_t i = 0; i < MAX_BLOCK_SAMPLES; i++)
+    {
+        // mixed code lengths, so the block ends at an awkward bit position
+        temp += (i % 7 == 0) ? noise(3000) : noise(20);
+        in[i] = (sensor_sample_t){ .timestamp_ms = (uint32_t)i * 1000 + (uint32_t)noise(2),
+                                   .temp = temp, .humidity = 5000 + noise(200) };
+    }
+
+    size_t fitted = round_trip(in, MAX_BLOCK_SAMPLES, sizeof(block));
+    CHECK(fitted > 1 && fitted < MAX_BLOCK_SAMPLES);
+
+    // the refused sample leaves the encoder exactly as it was
+    codec_encoder_init(&enc, block, sizeof(block));
+    for (size_t i = 0; i < fitted; i++)
+    {
+        CHECK(codec_encode(&enc, &in[i]));
+    }
+    codec_encoder_t before = enc;
+    uint8_t copy[sizeof(block)];
+    memcpy(copy, block, sizeof(block));
+    CHECK(!codec_encode(&enc, &in[fitted]));
+    CHECK(memcmp(&before, &enc, sizeof(enc)) == 0);
+    CHECK(memcmp(copy, block, sizeof(block)) == 0);
+
+    // every block size round-trips whatever fits
+    for (size_t size = 8; size <= 256; size++)
+    {
+        round_trip(in, MAX_BLOCK_SAMPLES, size);
+    }
+}
+
+/**
+ * @brief blocks that hold only the raw first sample
+ */
+static void test_first_sample_only(void)
+{
+    uint8_t block[8];
+    codec_encoder_t enc;
+    codec_decoder_t dec;
+    sensor_sample_t sample = { 0xDEADBEEFu, -1234, 9876 };
+    sensor_sample_t second = { 0xDEADBEEFu, -1234, 9876 };
+    sensor_sample_t out;
+
+    // too small for the 64-bit raw sample
+    codec_encoder_init(&enc, block, 7);
+    CHECK(!codec_encode(&enc, &sample));
+    CHECK(enc.count == 0);
+
+    // exactly one raw sample; even an all-zero delta no longer fits
+    codec_encoder_init(&enc, block, sizeof(block));
+    CHECK(codec_encode(&enc, &sample));
+    CHECK(!codec_encode(&enc, &second));
+    CHECK(enc.count == 1 && codec_encoded_bytes(&enc) == 8);
+
+    codec_decoder_init(&dec, block, sizeof(block));
+    CHECK(codec_decode(&dec, &out) && same(&out, &sample));
+    CHECK(!codec_decode(&dec, &out));
+
+    // a fresh block after one refusal starts raw again
+    sensor_sample_t in[] = { { 5000, 2100, 4000 } };
+    CHECK(round_trip(in, 1, 248) == 1);
+}
+
+static double seconds_since(const struct timespec* start)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)(now.tv_sec - start->tv_sec) + (double)(now.tv_nsec - start->tv_nsec) * 1e-9;
+}
+
+/**
+ * @brief compression and cost on a synthetic 1 Hz sensor series
+ *
+ * @details Temperature and humidity drift slowly with a few counts of
+ * noise, close to what a DHT20 reports indoors; the timestamp has a
+ * millisecond of scheduling jitter now and then
+ */
+static void bench(void)
+{
+    static sensor_sample_t series[BENCH_SAMPLES];
+    static uint8_t blocks[BENCH_SAMPLES / 8 + 1][HISTORY_BLOCK_SIZE];
+    static uint16_t counts[BENCH_SAMPLES / 8 + 1];
+    struct timespec start;
+
+    int32_t temp = 2200;
+    int32_t humidity = 4500;
+    uint32_t ts = 0;
+    for (size_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        if (i % 30 == 0)
+        {
+            temp += noise(3);
+            humidity += noise(8);
+        }
+        ts += 1000 + ((i % 16 == 0) ? (uint32_t)noise(1) : 0);
+        series[i] = (sensor_sample_t){ ts, temp + noise(2), humidity + noise(5) };
+    }
+
+    codec_encoder_t enc;
+    size_t block = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    codec_encoder_init(&enc, blocks[0], HISTORY_BLOCK_SIZE);
+    for (size_t i = 0; i < BENCH_SAMPLES; i++)
+    {
+        if (!codec_encode(&enc, &series[i]))
+        {
+            counts[block++] = enc.count;
+            codec_encoder_init(&enc, blocks[block], HISTORY_BLOCK_SIZE);
+            codec_encode(&enc, &series[i]);
+        }
+    }
+    counts[block] = enc.count;
+    double encode_s = seconds_since(&start);
+    size_t bytes = block * HISTORY_BLOCK_SIZE + codec_encoded_bytes(&enc);
+
+    size_t decoded = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t b = 0; b <= block; b++)
+    {
+        codec_decoder_t dec;
+        codec_decoder_init(&dec, blocks[b], HISTORY_BLOCK_SIZE);
+        for (uint16_t i = 0; i < counts[b]; i++)
+        {
+            sensor_sample_t out;
+            if (!codec_decode(&dec, &out) || !same(&out, &series[decoded]))
+            {
+                CHECK(false);
+                return;
+            }
+            decoded++;
+        }
+    }
+    double decode_s = seconds_since(&start);
+    CHECK(decoded == BENCH_SAMPLES);
+
+    printf("bench: %.2f bytes/sample (%.1f samples per %d-byte block), "
+           "encode %.0f ns/sample, decode %.0f ns/sample\n",
+           (double)bytes / BENCH_SAMPLES,
+           (double)BENCH_SAMPLES / (block + 1), HISTORY_BLOCK_SIZE,
+           encode_s * 1e9 / BENCH_SAMPLES,
+           decode_s * 1e9 / BENCH_SAMPLES);
+}
+
+int main(void)
+{
+    test_timestamp_wrap();
+    test_large_jumps();
+    test_full_block();
+    test_first_sample_only();
+    bench();
+
+    printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,243 @@
+/**
+ * @file test_usb_tx.c
+ * @brief Host test of the USB TX ring's record boundaries
+ *
+ * usb_tx.c runs against stand-ins for TinyUSB and stdio (stubs/). The
+ * endpoint budget is scripted per drain, and every drain must stop on a
+ * record boundary, including frames whose COBS payload contains '\n'.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tusb.h"
+#include "usb_tx.h"
+
+static int failures = 0;
+
+#define CHECK(cond)                                                         \
+    do                                                                      \
+    {                                                                       \
+        if (!(cond))                                                        \
+        {                                                                   \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            failures++;                                                     \
+        }                                                                   \
+    } while (0)
+
+// scripted endpoint
+static uint32_t budget = 0;       // bytes the endpoint accepts on the next drain
+static bool alarms_fail = false;
+static uint32_t alarms_armed = 0;
+static alarm_callback_t alarm_pending = NULL;   // last alarm armed, not yet fired
+static uint8_t sent[16384];
+static size_t sent_len = 0;
+
+bool tud_cdc_connected(void)
+{
+    return true;
+}
+
+uint32_t tud_cdc_write_available(void)
+{
+    return budget;
+}
+
+void stdio_put_string(const char* s, int len, bool newline, bool cr_translation)
+{
+    (void)newline;
+    (void)cr_translation;
+    memcpy(&sent[sent_len], s, (size_t)len);
+    sent_len += (size_t)len;
+}
+
+alarm_id_t add_alarm_in_ms(uint32_t ms, alarm_callback_t callback, void* user_data, bool fire_if_past)
+{
+    (void)ms;
+    (void)user_data;
+    (void)fire_if_past;
+    alarms_armed++;
+    if (alarms_fail)
+    {
+        return -1;
+    }
+    alarm_pending = callback;
+    return (alarm_id_t)alarms_armed;
+}
+
+/**
+ * @brief run the pending alarm, as its IRQ would
+ */
+static void fire_alarm(void)
+{
+    if (alarm_pending != NULL)
+    {
+        alarm_callback_t callback = alarm_pending;
+        alarm_pending = NULL;
+        callback(0, NULL);
+    }
+}
+
+void event_post(event_type_t type)
+{
+    (void)type;
+}
+
+/**
+ * @brief drain with a given endpoint budget
+ *
+ * @return bytes sent by this drain
+ */
+static size_t drain(uint32_t bytes)
+{
+    size_t before = sent_len;
+    budget = bytes;
+    usb_tx_drain();
+    return sent_len - before;
+}
+
+static void flush_all(void)
+{
+    drain(USB_TX_RING_SIZE);
+    sent_len = 0;
+}
+
+/**
+ * @brief a frame containing 0x0A and a CSV line, drained in small steps
+ */
+static void test_frame_with_newline(void)
+{
+    // COBS removes only 0x00, so 0x0A may appear anywhere inside a frame
+    static const uint8_t frame[] = { 0x00, 0x05, 0x01, 0x0A, 0x0A, 0x42, 0x03, 0x0A, 0x11, 0x00 };
+    static const char line[] = "1000,21.50,45.00\n";
+
+    CHECK(usb_tx_write(frame, sizeof(frame)));
+    CHECK(usb_tx_write(line, sizeof(line) - 1));
+
+    // any budget short of the whole frame sends nothing
+    for (uint32_t n = 1; n < sizeof(frame); n++)
+    {
+        CHECK(drain(n) == 0);
+    }
+    CHECK(usb_tx_pending() == sizeof(frame) + sizeof(line) - 1);
+
+    // a budget between the two boundaries sends the frame only
+    CHECK(drain(sizeof(frame) + 4) == sizeof(frame));
+    CHECK(memcmp(sent, frame, sizeof(frame)) == 0);
+
+    CHECK(drain(sizeof(line) - 2) == 0);
+    CHECK(drain(sizeof(line) - 1) == sizeof(line) - 1);
+    CHECK(memcmp(&sent[sizeof(frame)], line, sizeof(line) - 1) == 0);
+    CHECK(usb_tx_pending() == 0);
+    sent_len = 0;
+}
+
+static size_t ends[1024];        // record ends in the expected stream
+static size_t num_ends = 0;
+
+/**
+ * @brief true if the bytes sent so far stop at a record end
+ */
+static bool on_boundary(void)
+{
+    if (sent_len == 0)
+    {
+        return true;
+    }
+    for (size_t i = 0; i < num_ends; i++)
+    {
+        if (ends[i] == sent_len)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief many mixed records through the wrap, drained with odd budgets
+ */
+static void test_boundaries_across_wrap(void)
+{
+    static uint8_t expected[16384];
+    size_t expected_len = 0;
+
+    for (uint32_t i = 0; i < 600; i++)
+    {
+        // frames full of 0x0A, and text lines
+        uint8_t record[40];
+        size_t len = 5 + i % 31;
+        memset(record, (i % 2) ? 0x0A : 0x5A, len);
+        record[len - 1] = (i % 2) ? 0x00 : '\n';
+
+        while (usb_tx_pending() + len > USB_TX_RING_SIZE)
+        {
+            drain(37);
+            CHECK(on_boundary());
+        }
+        CHECK(usb_tx_write(record, len));
+        memcpy(&expected[expected_len], record, len);
+        expected_len += len;
+        ends[num_ends++] = expected_len;
+
+        drain(i % 53);
+        CHECK(on_boundary());
+    }
+    drain(USB_TX_RING_SIZE);
+
+    CHECK(sent_len == expected_len);
+    CHECK(memcmp(sent, expected, expected_len) == 0);
+    sent_len = 0;
+}
+
+/**
+ * @brief more records than the boundary queue holds are dropped whole
+ */
+static void test_record_queue_full(void)
+{
+    const usb_tx_stats_t* stats = usb_tx_get_stats();
+    uint32_t dropped = stats->records_dropped;
+
+    for (uint32_t i = 0; i < USB_TX_MAX_RECORDS; i++)
+    {
+        CHECK(usb_tx_write("x\n", 2));
+    }
+    CHECK(!usb_tx_write("y\n", 2));
+    CHECK(stats->records_dropped == dropped + 1);
+
+    CHECK(drain(USB_TX_RING_SIZE) == 2 * USB_TX_MAX_RECORDS);
+    CHECK(usb_tx_write("z\n", 2));
+    flush_all();
+}
+
+/**
+ * @brief a retry alarm that cannot be armed is tried again on the next drain
+ */
+static void test_retry_alarm_fails(void)
+{
+    CHECK(usb_tx_write("12345\n", 6));
+    fire_alarm();
+
+    alarms_fail = true;
+    uint32_t armed = alarms_armed;
+    drain(2);
+    drain(2);
+    CHECK(alarms_armed == armed + 2);
+
+    alarms_fail = false;
+    drain(2);
+    drain(2);
+    CHECK(alarms_armed == armed + 3);   // armed once, then left pending
+    flush_all();
+}
+
+int main(void)
+{
+    test_frame_with_newline();
+    test_boundaries_across_wrap();
+    test_record_queue_full();
+    test_retry_alarm_fails();
+
+    printf(failures ? "%d check(s) failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}